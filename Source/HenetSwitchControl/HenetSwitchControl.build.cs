@@ -40,12 +40,16 @@ public class HenetSwitchControl : ModuleRules
                 "Engine",
                 "Slate",
                 "SlateCore",
-                "Projects" // Needed for IPluginManager
+                "Projects", // Needed for IPluginManager
+                "Sockets",
+                "DeveloperSettings",
+                "Networking" // UDP multicast for cluster sync
                 // ... add private dependencies here
             }
             );
         
-        // This plugin is Windows-only.
+        // Serial ports are Windows-only. The non-Windows path only stubs the reader out;
+        // the plugin is not allow-listed on other platforms until one has been built there.
         // Add definitions, includes, and libraries only for Windows.
         if (Target.Platform == UnrealTargetPlatform.Win64)
         {
@@ -0,0 +1,90 @@
+// Copyright Henet LLC 2025
+// Implementation of the analog sample channel ring
+
+#include "HenetAnalogChannel.h"
+
+static_assert((FHenetAnalogChannel::RingCapacity & (FHenetAnalogChannel::RingCapacity - 1)) == 0, "RingCapacity must be a power of two");
+
+FHenetAnalogChannel::FHenetAnalogChannel()
+    : Decimation(1)
+    , SmoothingAlpha(1.0f)
+    , FilteredValue(0.0f)
+    , DecimationCounter(0)
+    , bHasFilteredValue(false)
+    , LatestValue(0.0f)
+    , WriteIndex(0)
+    , ReadIndex(0)
+{
+    FMemory::Memzero(Ring, sizeof(Ring));
+}
+
+void FHenetAnalogChannel::Configure(int32 InDecimation, float InSmoothing)
+{
+    Decimation.Store(FMath::Max(1, InDecimation), EMemoryOrder::Relaxed);
+
+    // Smoothing is exposed as "how much of the old value to keep"; the filter wants the opposite.
+    SmoothingAlpha.store(1.0f - FMath::Clamp(InSmoothing, 0.0f, 0.99f), std::memory_order_relaxed);
+}
+
+void FHenetAnalogChannel::CopyConfiguration(const FHenetAnalogChannel& Other)
+{
+    Decimation.Store(Other.Decimation.Load(EMemoryOrder::Relaxed), EMemoryOrder::Relaxed);
+    SmoothingAlpha.store(Other.SmoothingAlpha.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void FHenetAnalogChannel::PushSample(uint16 RawValue)
+{
+    const float Raw = static_cast<float>(RawValue);
+    const float Alpha = SmoothingAlpha.load(std::memory_order_relaxed);
+
+    // Seed the filter with the first sample so it doesn't ramp up from zero.
+    FilteredValue = bHasFilteredValue ? FMath::Lerp(FilteredValue, Raw, Alpha) : Raw;
+    bHasFilteredValue = true;
+    LatestValue.store(FilteredValue, std::memory_order_relaxed);
+
+    if (++DecimationCounter < Decimation.Load(EMemoryOrder::Relaxed))
+    {
+        return;
+    }
+    DecimationCounter = 0;
+
+    const uint32 Index = WriteIndex.Load(EMemoryOrder::Relaxed);
+    Ring[Index & (RingCapacity - 1)] = FilteredValue;
+
+    // Publish the slot only after it has been written.
+    WriteIndex.Store(Index + 1);
+}
+
+int32 FHenetAnalogChannel::ConsumeSamples(TArray<float>& OutSamples)
+{
+    OutSamples.Reset();
+
+    const uint32 End = WriteIndex.Load();
+    uint32 Begin = ReadIndex;
+
+    // If the writer lapped us, the oldest slots have already been overwritten.
+    if (End - Begin > RingCapacity)
+    {
+        Begin = End - RingCapacity;
+    }
+
+    const int32 Count = static_cast<int32>(End - Begin);
+    OutSamples.Reserve(Count);
+    for (uint32 Index = Begin; Index != End; ++Index)
+    {
+        OutSamples.Add(Ring[Index & (RingCapacity - 1)]);
+    }
+
+    // The writer may have kept going while we copied. Anything it overwrote in the
+    // meantime is no longer the sample we meant to read, so drop it from the front.
+    // The unpublished slot at EndAfterCopy may be mid-write too, hence the + 1.
+    const uint32 EndAfterCopy = WriteIndex.Load();
+    if (EndAfterCopy + 1 - Begin > RingCapacity)
+    {
+        const int32 Overwritten = FMath::Min(Count, static_cast<int32>(EndAfterCopy + 1 - Begin - RingCapacity));
+        OutSamples.RemoveAt(0, Overwritten, EAllowShrinking::No);
+    }
+
+    ReadIndex = End;
+    return OutSamples.Num();
+}
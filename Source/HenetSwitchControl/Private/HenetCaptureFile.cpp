@@ -0,0 +1,220 @@
+// Copyright Henet LLC 2025
+// Implementation of the capture file writer and reader.
+
+#include "HenetCaptureFile.h"
+#include "HenetSwitchControlModule.h"
+#include "Async/MappedFileHandle.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+/** Buffer size at which the writer flushes, regardless of time. */
+static constexpr int32 CaptureFlushBytes = 64 * 1024;
+
+/** Longest a read stays in the buffer while data is flowing. */
+static constexpr double CaptureFlushSeconds = 1.0;
+
+FHenetCaptureWriter::~FHenetCaptureWriter()
+{
+	Close();
+}
+
+FString FHenetCaptureWriter::ResolvePath(const FString& FileName, const FString& PortName)
+{
+	FString Result = FileName.TrimStartAndEnd();
+	if (Result.IsEmpty())
+	{
+		Result = FString::Printf(TEXT("%s_%s.hcap"), *PortName.TrimStartAndEnd().ToUpper(), *FDateTime::Now().ToString());
+	}
+	if (FPaths::IsRelative(Result))
+	{
+		Result = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("HenetCaptures"), Result);
+	}
+	return FPaths::ConvertRelativePathToFull(Result);
+}
+
+bool FHenetCaptureWriter::Open(const FString& InPath, uint32 BaudRate)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(InPath));
+
+	File.Reset(PlatformFile.OpenWrite(*InPath));
+	if (!File)
+	{
+		UE_LOG(LogHenetSwitchControl, Error, TEXT("Could not create capture file %s."), *InPath);
+		return false;
+	}
+
+	Path = InPath;
+	BytesCaptured = 0;
+	LastCycles = LastFlushCycles = FPlatformTime::Cycles64();
+
+	FHenetCaptureFileHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = FHenetCaptureFileHeader::ExpectedMagic;
+	Header.Version = FHenetCaptureFileHeader::ExpectedVersion;
+	Header.HeaderSize = sizeof(FHenetCaptureFileHeader);
+	Header.StartUtcTicks = FDateTime::UtcNow().GetTicks();
+	Header.BaudRate = BaudRate;
+
+	Buffer.Reset(CaptureFlushBytes + 1024);
+	Buffer.Append(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+	Flush();
+
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("Capturing raw serial data to %s."), *Path);
+	return true;
+}
+
+void FHenetCaptureWriter::Append(uint64 Cycles, const uint8* Bytes, int32 Count)
+{
+	if (!File)
+	{
+		return;
+	}
+
+	for (int32 Offset = 0; Offset < Count; )
+	{
+		const int32 Length = FMath::Min(Count - Offset, static_cast<int32>(MAX_uint16));
+		const uint32 DeltaMicros = static_cast<uint32>(FMath::Min<double>(FPlatformTime::ToSeconds64(Cycles - LastCycles) * 1000000.0, MAX_uint32));
+		const uint16 Length16 = static_cast<uint16>(Length);
+		LastCycles = Cycles;
+
+		Buffer.Append(reinterpret_cast<const uint8*>(&DeltaMicros), sizeof(DeltaMicros));
+		Buffer.Append(reinterpret_cast<const uint8*>(&Length16), sizeof(Length16));
+		Buffer.Append(Bytes + Offset, Length);
+		Offset += Length;
+	}
+	BytesCaptured += Count;
+
+	if (Buffer.Num() >= CaptureFlushBytes || FPlatformTime::ToSeconds64(Cycles - LastFlushCycles) >= CaptureFlushSeconds)
+	{
+		Flush();
+		LastFlushCycles = Cycles;
+	}
+}
+
+void FHenetCaptureWriter::Flush()
+{
+	if (File && Buffer.Num() > 0)
+	{
+		if (!File->Write(Buffer.GetData(), Buffer.Num()))
+		{
+			UE_LOG(LogHenetSwitchControl, Error, TEXT("Writing to capture file %s failed; capture stopped."), *Path);
+			File.Reset();
+		}
+		else
+		{
+			File->Flush();
+		}
+	}
+	Buffer.Reset();
+}
+
+void FHenetCaptureWriter::Close()
+{
+	if (File)
+	{
+		Flush();
+		File.Reset();
+		UE_LOG(LogHenetSwitchControl, Log, TEXT("Capture %s closed (%lld bytes)."), *Path, BytesCaptured);
+	}
+}
+
+FHenetCaptureReader::FHenetCaptureReader()
+	: Data(nullptr)
+	, Size(0)
+	, Offset(0)
+	, ElapsedMicros(0)
+	, StartUtcTicks(0)
+{
+}
+
+FHenetCaptureReader::~FHenetCaptureReader()
+{
+	// The region must go before the handle it was mapped from.
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+bool FHenetCaptureReader::Open(const FString& Path)
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedFile.Empty();
+	Data = nullptr;
+	Size = Offset = 0;
+	ElapsedMicros = 0;
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+	if (MappedFile && MappedFile->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize(), true));
+	}
+
+	if (MappedRegion)
+	{
+		Data = MappedRegion->GetMappedPtr();
+		Size = MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedFile, *Path, FILEREAD_Silent))
+	{
+		Data = LoadedFile.GetData();
+		Size = LoadedFile.Num();
+	}
+	else
+	{
+		UE_LOG(LogHenetSwitchControl, Error, TEXT("Could not open capture file %s."), *Path);
+		return false;
+	}
+
+	FHenetCaptureFileHeader Header;
+	if (Size < static_cast<int64>(sizeof(Header)))
+	{
+		UE_LOG(LogHenetSwitchControl, Error, TEXT("%s is too small to be a capture file."), *Path);
+		return false;
+	}
+	FMemory::Memcpy(&Header, Data, sizeof(Header));
+
+	if (Header.Magic != FHenetCaptureFileHeader::ExpectedMagic || Header.Version != FHenetCaptureFileHeader::ExpectedVersion
+		|| Header.HeaderSize < sizeof(Header) || Header.HeaderSize > Size)
+	{
+		UE_LOG(LogHenetSwitchControl, Error, TEXT("%s is not a supported capture file (magic 0x%08X, version %u)."), *Path, Header.Magic, Header.Version);
+		return false;
+	}
+
+	StartUtcTicks = Header.StartUtcTicks;
+	Offset = Header.HeaderSize;
+	return true;
+}
+
+bool FHenetCaptureReader::Next(uint64& OutMicros, const uint8*& OutBytes, int32& OutCount)
+{
+	if (Size - Offset < HenetCaptureRecordHeaderSize)
+	{
+		return false;
+	}
+
+	uint32 DeltaMicros = 0;
+	uint16 Length = 0;
+	FMemory::Memcpy(&DeltaMicros, Data + Offset, sizeof(DeltaMicros));
+	FMemory::Memcpy(&Length, Data + Offset + sizeof(DeltaMicros), sizeof(Length));
+
+	if (Size - Offset - HenetCaptureRecordHeaderSize < Length)
+	{
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("Capture file ends with a truncated record; stopping there."));
+		Offset = Size;
+		return false;
+	}
+
+	ElapsedMicros += DeltaMicros;
+	OutMicros = ElapsedMicros;
+	OutBytes = Data + Offset + HenetCaptureRecordHeaderSize;
+	OutCount = Length;
+	Offset += HenetCaptureRecordHeaderSize + Length;
+	return true;
+}
@@ -0,0 +1,409 @@
+// Copyright Henet LLC 2025
+// Implementation of cluster-synchronized event delivery.
+
+#include "HenetClusterSync.h"
+#include "HenetSerialPortReader.h"
+#include "HenetSwitchControlModule.h"
+#include "Common/UdpSocketBuilder.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Guid.h"
+#include "Misc/Parse.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+static FString GHenetClusterRole = TEXT("Off");
+static FAutoConsoleVariableRef CVarHenetClusterRole(
+	TEXT("henet.Cluster.Role"),
+	GHenetClusterRole,
+	TEXT("Off, Owner or Peer. The owner opens the switch box and distributes its events; peers open no port and apply the owner's events in the same frame. Read when a connection opens; -HenetClusterRole= on the command line takes precedence."),
+	ECVF_Default);
+
+static FString GHenetClusterGroup = TEXT("239.255.72.78");
+static FAutoConsoleVariableRef CVarHenetClusterGroup(
+	TEXT("henet.Cluster.Group"),
+	GHenetClusterGroup,
+	TEXT("IPv4 multicast group used to distribute switch events within the cluster."),
+	ECVF_Default);
+
+static int32 GHenetClusterPort = 47878;
+static FAutoConsoleVariableRef CVarHenetClusterPort(
+	TEXT("henet.Cluster.Port"),
+	GHenetClusterPort,
+	TEXT("UDP port used to distribute switch events within the cluster."),
+	ECVF_Default);
+
+static int32 GHenetClusterFrameDelay = 3;
+static FAutoConsoleVariableRef CVarHenetClusterFrameDelay(
+	TEXT("henet.Cluster.FrameDelay"),
+	GHenetClusterFrameDelay,
+	TEXT("How many frames after the owner receives an event every node applies it. Must cover the network delay to the slowest peer."),
+	ECVF_Default);
+
+/** Packet layout constants. All fields little-endian. */
+namespace HenetClusterPacket
+{
+	constexpr uint32 Magic = 0x554C4348; // "HCLU"
+	constexpr uint8 Version = 2;
+
+	/** Header flag: the owner's device is connected. */
+	constexpr uint8 FlagDeviceConnected = 1 << 0;
+
+	/** Per-event flags. */
+	constexpr uint8 EventHeartbeat = 1 << 0;
+	constexpr uint8 EventConnectionStatus = 1 << 1;
+	constexpr uint8 EventConnected = 1 << 2;
+	constexpr uint8 EventPressed = 1 << 3;
+
+	/** Batches are repeated in this many packets at most. */
+	constexpr int32 MaxRepeatedBatches = 3;
+
+	/** Keeps a packet (with repeats) well under a typical MTU. */
+	constexpr int32 MaxEventsPerBatch = 128;
+
+	constexpr int32 MaxPortNameLength = 32;
+	constexpr int32 MaxPacketSize = 2048;
+}
+
+/** Peers report the owner as gone after this long without a packet. */
+static constexpr double OwnerTimeoutSeconds = 2.0;
+
+template<typename T>
+static void AppendValue(TArray<uint8>& Buffer, T Value)
+{
+	Buffer.Append(reinterpret_cast<const uint8*>(&Value), sizeof(T));
+}
+
+template<typename T>
+static bool ReadValue(const uint8* Data, int32 Size, int32& Offset, T& OutValue)
+{
+	if (Size - Offset < static_cast<int32>(sizeof(T)))
+	{
+		return false;
+	}
+	FMemory::Memcpy(&OutValue, Data + Offset, sizeof(T));
+	Offset += sizeof(T);
+	return true;
+}
+
+FHenetClusterSync::FHenetClusterSync(EHenetClusterRole InRole, const FString& InPortName)
+	: Role(InRole)
+	, PortName(InPortName.TrimStartAndEnd().ToUpper().Left(HenetClusterPacket::MaxPortNameLength))
+{
+	FMemory::Memzero(OffsetSamples, sizeof(OffsetSamples));
+
+	if (Role == EHenetClusterRole::Owner)
+	{
+		// Unique per owner run, so peers can tell a restarted owner from a stale packet.
+		const FGuid Guid = FGuid::NewGuid();
+		SessionId = Guid.A ^ Guid.B ^ Guid.C ^ Guid.D;
+	}
+}
+
+FHenetClusterSync::~FHenetClusterSync()
+{
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+}
+
+EHenetClusterRole FHenetClusterSync::GetConfiguredRole()
+{
+	FString RoleName = GHenetClusterRole;
+	FParse::Value(FCommandLine::Get(), TEXT("HenetClusterRole="), RoleName);
+
+	if (RoleName.Equals(TEXT("Owner"), ESearchCase::IgnoreCase))
+	{
+		return EHenetClusterRole::Owner;
+	}
+	if (RoleName.Equals(TEXT("Peer"), ESearchCase::IgnoreCase))
+	{
+		return EHenetClusterRole::Peer;
+	}
+	return EHenetClusterRole::Off;
+}
+
+bool FHenetClusterSync::Open()
+{
+	FIPv4Address GroupIp;
+	if (!FIPv4Address::Parse(GHenetClusterGroup, GroupIp) || !GroupIp.IsMulticastAddress())
+	{
+		UE_LOG(LogHenetSwitchControl, Error, TEXT("Cluster sync: henet.Cluster.Group '%s' is not an IPv4 multicast address."), *GHenetClusterGroup);
+		return false;
+	}
+
+	const uint16 Port = static_cast<uint16>(GHenetClusterPort);
+	FUdpSocketBuilder Builder(TEXT("HenetClusterSync"));
+	Builder.AsNonBlocking().AsReusable().WithMulticastLoopback().WithMulticastTtl(1);
+
+	if (Role == EHenetClusterRole::Peer)
+	{
+		// Every peer on the host binds the same port; AsReusable lets them share it.
+		Builder.BoundToAddress(FIPv4Address::Any).BoundToPort(Port).JoinedToGroup(GroupIp).WithReceiveBufferSize(64 * 1024);
+	}
+
+	Socket = Builder.Build();
+	if (!Socket)
+	{
+		UE_LOG(LogHenetSwitchControl, Error, TEXT("Cluster sync: could not create the multicast socket for %s:%d."), *GHenetClusterGroup, GHenetClusterPort);
+		return false;
+	}
+
+	GroupAddress = FIPv4Endpoint(GroupIp, Port).ToInternetAddr();
+	PacketBuffer.Reserve(HenetClusterPacket::MaxPacketSize);
+
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("Cluster sync: %s for %s on %s:%d, %d frame(s) delay."),
+		Role == EHenetClusterRole::Owner ? TEXT("owner") : TEXT("peer"), *PortName, *GHenetClusterGroup, GHenetClusterPort, GHenetClusterFrameDelay);
+	return true;
+}
+
+void FHenetClusterSync::Process(TArray<FHenetSwitchEvent>& InOutEvents, bool bDeviceConnected)
+{
+	if (Role == EHenetClusterRole::Owner)
+	{
+		ProcessOwner(InOutEvents, bDeviceConnected);
+	}
+	else if (Role == EHenetClusterRole::Peer)
+	{
+		ProcessPeer(InOutEvents);
+	}
+}
+
+void FHenetClusterSync::ReleaseDue(TArray<FBatch>& Batches, int64 DueOwnerFrame, TArray<FHenetSwitchEvent>& OutEvents)
+{
+	int32 NumDue = 0;
+	while (NumDue < Batches.Num() && static_cast<int64>(Batches[NumDue].TargetFrame) <= DueOwnerFrame)
+	{
+		OutEvents.Append(Batches[NumDue].Events);
+		++NumDue;
+	}
+	Batches.RemoveAt(0, NumDue, EAllowShrinking::No);
+}
+
+void FHenetClusterSync::ProcessOwner(TArray<FHenetSwitchEvent>& InOutEvents, bool bDeviceConnected)
+{
+	const uint64 Frame = GFrameCounter;
+
+	// A batch never holds more than fits a packet. The rest moves on to the next frame's batch,
+	// on the owner as on the peers, so every node still applies the same events in the same frame.
+	if (OverflowEvents.Num() > 0)
+	{
+		InOutEvents.Insert(OverflowEvents, 0);
+		OverflowEvents.Reset();
+	}
+	if (InOutEvents.Num() > HenetClusterPacket::MaxEventsPerBatch)
+	{
+		UE_LOG(LogHenetSwitchControl, Log, TEXT("Cluster sync: %d events in one frame; %d deferred to the next frame."),
+			InOutEvents.Num(), InOutEvents.Num() - HenetClusterPacket::MaxEventsPerBatch);
+		OverflowEvents.Append(InOutEvents.GetData() + HenetClusterPacket::MaxEventsPerBatch, InOutEvents.Num() - HenetClusterPacket::MaxEventsPerBatch);
+		InOutEvents.SetNum(HenetClusterPacket::MaxEventsPerBatch, EAllowShrinking::No);
+	}
+
+	if (InOutEvents.Num() > 0)
+	{
+		FBatch Batch;
+		Batch.TargetFrame = Frame + FMath::Max(GHenetClusterFrameDelay, 0);
+		Batch.Events = InOutEvents;
+		HeldBatches.Add(Batch);
+		RecentBatches.Add(MoveTemp(Batch));
+		if (RecentBatches.Num() > HenetClusterPacket::MaxRepeatedBatches)
+		{
+			RecentBatches.RemoveAt(0, RecentBatches.Num() - HenetClusterPacket::MaxRepeatedBatches, EAllowShrinking::No);
+		}
+	}
+
+	// Repeating a batch after its target frame cannot help anyone apply it on time.
+	RecentBatches.RemoveAll([Frame](const FBatch& Batch) { return Batch.TargetFrame < Frame; });
+
+	if (Socket)
+	{
+		// Sent every frame, events or not: it is also the frame beacon peers estimate their offset from.
+		PacketBuffer.Reset();
+		AppendValue<uint32>(PacketBuffer, HenetClusterPacket::Magic);
+		AppendValue<uint8>(PacketBuffer, HenetClusterPacket::Version);
+		AppendValue<uint8>(PacketBuffer, bDeviceConnected ? HenetClusterPacket::FlagDeviceConnected : 0);
+		AppendValue<uint8>(PacketBuffer, static_cast<uint8>(RecentBatches.Num()));
+		AppendValue<uint8>(PacketBuffer, static_cast<uint8>(PortName.Len()));
+		AppendValue<uint64>(PacketBuffer, Frame);
+		AppendValue<uint32>(PacketBuffer, SessionId);
+		for (TCHAR Char : PortName)
+		{
+			AppendValue<uint8>(PacketBuffer, static_cast<uint8>(Char));
+		}
+
+		for (const FBatch& Batch : RecentBatches)
+		{
+			const int32 NumEvents = Batch.Events.Num();
+			AppendValue<uint64>(PacketBuffer, Batch.TargetFrame);
+			AppendValue<uint16>(PacketBuffer, static_cast<uint16>(NumEvents));
+			for (int32 Index = 0; Index < NumEvents; ++Index)
+			{
+				const FHenetSwitchEvent& Event = Batch.Events[Index];
+				uint8 Flags = 0;
+				Flags |= Event.bIsHeartbeat ? HenetClusterPacket::EventHeartbeat : 0;
+				Flags |= Event.bIsConnectionStatus ? HenetClusterPacket::EventConnectionStatus : 0;
+				Flags |= Event.bIsConnected ? HenetClusterPacket::EventConnected : 0;
+				Flags |= Event.bIsPressed ? HenetClusterPacket::EventPressed : 0;
+				AppendValue<uint8>(PacketBuffer, Flags);
+				AppendValue<uint8>(PacketBuffer, static_cast<uint8>(Event.SwitchNumber));
+			}
+		}
+
+		int32 BytesSent = 0;
+		if (!Socket->SendTo(PacketBuffer.GetData(), PacketBuffer.Num(), BytesSent, *GroupAddress))
+		{
+			UE_LOG(LogHenetSwitchControl, Verbose, TEXT("Cluster sync: send failed."));
+		}
+	}
+
+	InOutEvents.Reset();
+	ReleaseDue(HeldBatches, Frame, InOutEvents);
+}
+
+bool FHenetClusterSync::ReadPacket(const uint8* Data, int32 Size)
+{
+	int32 Offset = 0;
+	uint32 Magic = 0;
+	uint8 Version = 0, Flags = 0, NumBatches = 0, NameLength = 0;
+	uint64 OwnerFrame = 0;
+	uint32 Session = 0;
+
+	if (!ReadValue(Data, Size, Offset, Magic) || Magic != HenetClusterPacket::Magic
+		|| !ReadValue(Data, Size, Offset, Version) || Version != HenetClusterPacket::Version
+		|| !ReadValue(Data, Size, Offset, Flags)
+		|| !ReadValue(Data, Size, Offset, NumBatches)
+		|| !ReadValue(Data, Size, Offset, NameLength)
+		|| !ReadValue(Data, Size, Offset, OwnerFrame)
+		|| !ReadValue(Data, Size, Offset, Session)
+		|| Size - Offset < NameLength)
+	{
+		return false;
+	}
+
+	// Several switch boxes may share the group; only take the one this connection mirrors.
+	const FString SenderPort(NameLength, reinterpret_cast<const ANSICHAR*>(Data + Offset));
+	Offset += NameLength;
+	if (SenderPort != PortName)
+	{
+		return false;
+	}
+
+	if (Session != SessionId)
+	{
+		// A new owner run numbers its frames from scratch; nothing learned from the old one applies.
+		if (SessionId != 0)
+		{
+			UE_LOG(LogHenetSwitchControl, Log, TEXT("Cluster sync: owner of %s restarted, resynchronizing."), *PortName);
+		}
+		SessionId = Session;
+		LastReceivedTarget = 0;
+		NumSamples = NextSample = 0;
+		HeldBatches.Reset();
+	}
+
+	OffsetSamples[NextSample] = static_cast<int64>(OwnerFrame) - static_cast<int64>(GFrameCounter);
+	NextSample = (NextSample + 1) % NumOffsetSamples;
+	NumSamples = FMath::Min(NumSamples + 1, NumOffsetSamples);
+
+	bOwnerConnected = (Flags & HenetClusterPacket::FlagDeviceConnected) != 0;
+	LastPacketTime = FPlatformTime::Seconds();
+
+	const uint64 ReceivedCycles = FPlatformTime::Cycles64();
+	for (int32 BatchIndex = 0; BatchIndex < NumBatches; ++BatchIndex)
+	{
+		uint64 TargetFrame = 0;
+		uint16 NumEvents = 0;
+		if (!ReadValue(Data, Size, Offset, TargetFrame) || !ReadValue(Data, Size, Offset, NumEvents) || Size - Offset < NumEvents * 2)
+		{
+			return false;
+		}
+
+		if (TargetFrame <= LastReceivedTarget)
+		{
+			// A repeat of a batch we already have.
+			Offset += NumEvents * 2;
+			continue;
+		}
+		LastReceivedTarget = TargetFrame;
+
+		FBatch& Batch = HeldBatches.AddDefaulted_GetRef();
+		Batch.TargetFrame = TargetFrame;
+		Batch.Events.Reserve(NumEvents);
+		for (int32 Index = 0; Index < NumEvents; ++Index)
+		{
+			const uint8 EventFlags = Data[Offset++];
+			const uint8 SwitchNumber = Data[Offset++];
+
+			// The owner's device state reaches peers through the header flag (see ProcessPeer).
+			if (EventFlags & HenetClusterPacket::EventConnectionStatus)
+			{
+				continue;
+			}
+
+			FHenetSwitchEvent& Event = Batch.Events.AddDefaulted_GetRef();
+			Event.bIsHeartbeat = (EventFlags & HenetClusterPacket::EventHeartbeat) != 0;
+			Event.bIsPressed = (EventFlags & HenetClusterPacket::EventPressed) != 0;
+			Event.SwitchNumber = SwitchNumber;
+
+			// The owner's clock means nothing here; the best local time is when it arrived.
+			Event.TimestampCycles = ReceivedCycles;
+		}
+
+		if (static_cast<int64>(TargetFrame) - GetFrameOffset() < static_cast<int64>(GFrameCounter))
+		{
+			++LateBatches;
+			UE_LOG(LogHenetSwitchControl, Verbose, TEXT("Cluster sync: batch for frame %llu arrived late (%d so far); consider raising henet.Cluster.FrameDelay."), TargetFrame, LateBatches);
+		}
+	}
+	return true;
+}
+
+int64 FHenetClusterSync::GetFrameOffset() const
+{
+	int64 Offset = NumSamples > 0 ? OffsetSamples[0] : 0;
+	for (int32 Index = 1; Index < NumSamples; ++Index)
+	{
+		Offset = FMath::Max(Offset, OffsetSamples[Index]);
+	}
+	return Offset;
+}
+
+void FHenetClusterSync::ProcessPeer(TArray<FHenetSwitchEvent>& OutEvents)
+{
+	OutEvents.Reset();
+
+	if (Socket)
+	{
+		PacketBuffer.SetNumUninitialized(HenetClusterPacket::MaxPacketSize, EAllowShrinking::No);
+		int32 BytesRead = 0;
+		while (Socket->Recv(PacketBuffer.GetData(), PacketBuffer.Num(), BytesRead) && BytesRead > 0)
+		{
+			ReadPacket(PacketBuffer.GetData(), BytesRead);
+		}
+	}
+
+	if (bOwnerConnected && FPlatformTime::Seconds() - LastPacketTime > OwnerTimeoutSeconds)
+	{
+		// The owner went quiet: whatever it last reported can't be trusted any more.
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("Cluster sync: no packets from the owner of %s for %.1f s."), *PortName, OwnerTimeoutSeconds);
+		bOwnerConnected = false;
+		HeldBatches.Reset();
+	}
+	else if (NumSamples > 0)
+	{
+		ReleaseDue(HeldBatches, static_cast<int64>(GFrameCounter) + GetFrameOffset(), OutEvents);
+	}
+
+	// Status follows the owner's flag (and the timeout above) rather than the owner's status
+	// events, so listeners see Connected again once packets resume after a blip.
+	if (bOwnerConnected != bReportedConnected)
+	{
+		bReportedConnected = bOwnerConnected;
+		OutEvents.Add(FHenetSwitchEvent::MakeConnectionStatus(bOwnerConnected));
+	}
+}
@@ -0,0 +1,177 @@
+// Copyright Henet LLC 2025
+// Implementation of the port-keyed connection registry.
+
+#include "HenetConnectionRegistry.h"
+#include "HenetSerialConnection.h"
+#include "HenetSwitchControlModule.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+static float GHenetConnectionLingerSeconds = 5.0f;
+static FAutoConsoleVariableRef CVarHenetConnectionLingerSeconds(
+	TEXT("henet.ConnectionLingerSeconds"),
+	GHenetConnectionLingerSeconds,
+	TEXT("How long a serial port stays open after its last connection reference is released, so that level transitions can reuse it."),
+	ECVF_Default);
+
+FHenetConnectionRegistry::~FHenetConnectionRegistry()
+{
+	Shutdown();
+}
+
+FString FHenetConnectionRegistry::MakeKey(const FString& PortName)
+{
+	return PortName.TrimStartAndEnd().ToUpper();
+}
+
+UHenetSerialConnection* FHenetConnectionRegistry::Acquire(const FString& PortName)
+{
+	const FString Key = MakeKey(PortName);
+	FEntry& Entry = Entries.FindOrAdd(Key);
+
+	UHenetSerialConnection* Connection = Entry.Connection.Get();
+	if (!Connection)
+	{
+		// First use of this port (or the previous object was destroyed): create a new connection.
+		// The connection roots itself while open, so the registry only needs a weak pointer.
+		Connection = NewObject<UHenetSerialConnection>();
+		Entry.Connection = Connection;
+		Entry.RefCount = 0;
+	}
+	else if (Entry.RefCount == 0)
+	{
+		UE_LOG(LogHenetSwitchControl, Log, TEXT("Connection registry: Reusing warm connection to %s."), *Key);
+
+		// Nobody was listening while the port lingered; those events are stale now.
+		Connection->EventQueue.Empty();
+	}
+
+	// The reader thread ends on its own when the device goes away. Restart it so the
+	// caller gets a live reader rather than a dead handle; restarting in place keeps the
+	// state other users of the connection set up (callbacks, waits, analog configuration).
+	if (!Connection->IsOpen())
+	{
+		Connection->Open(Key);
+	}
+	else if (Connection->HasReaderStopped())
+	{
+		Connection->RestartReader();
+	}
+
+	++Entry.RefCount;
+	Entry.CloseTime = 0.0;
+	return Connection;
+}
+
+void FHenetConnectionRegistry::Release(UHenetSerialConnection* Connection)
+{
+	if (!Connection)
+	{
+		return;
+	}
+
+	FEntry* Entry = Entries.Find(MakeKey(Connection->GetPortName()));
+	if (!Entry || Entry->Connection.Get() != Connection)
+	{
+		// Not one of ours; honour the old behaviour of closing it straight away.
+		Connection->Close();
+		return;
+	}
+
+	if (Entry->RefCount <= 0)
+	{
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("Connection registry: %s released more times than it was opened."), *Connection->GetPortName());
+		return;
+	}
+
+	if (--Entry->RefCount > 0)
+	{
+		return;
+	}
+
+	if (GHenetConnectionLingerSeconds <= 0.0f)
+	{
+		CloseEntry(*Entry);
+		Entries.Remove(MakeKey(Connection->GetPortName()));
+		return;
+	}
+
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("Connection registry: Last reference to %s released, keeping it open for %.1f s."),
+		*Connection->GetPortName(), GHenetConnectionLingerSeconds);
+	Entry->CloseTime = FPlatformTime::Seconds() + GHenetConnectionLingerSeconds;
+
+	if (!LingerTickerHandle.IsValid())
+	{
+		LingerTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateRaw(this, &FHenetConnectionRegistry::TickLinger), 0.5f);
+	}
+}
+
+bool FHenetConnectionRegistry::TickLinger(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+	bool bAnyLingering = false;
+
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		FEntry& Entry = It.Value();
+		if (Entry.RefCount > 0)
+		{
+			continue;
+		}
+
+		if (Now >= Entry.CloseTime)
+		{
+			UE_LOG(LogHenetSwitchControl, Log, TEXT("Connection registry: Linger period for %s expired, closing."), *It.Key());
+			CloseEntry(Entry);
+			It.RemoveCurrent();
+		}
+		else
+		{
+			bAnyLingering = true;
+		}
+	}
+
+	if (!bAnyLingering)
+	{
+		// Returning false removes the ticker; it is re-added by the next Release.
+		LingerTickerHandle.Reset();
+	}
+	return bAnyLingering;
+}
+
+void FHenetConnectionRegistry::CloseEntry(FEntry& Entry)
+{
+	if (UHenetSerialConnection* Connection = Entry.Connection.Get())
+	{
+		Connection->Close();
+	}
+	Entry.Connection.Reset();
+	Entry.RefCount = 0;
+}
+
+void FHenetConnectionRegistry::ForEachConnection(TFunctionRef<void(UHenetSerialConnection&)> Visitor) const
+{
+	for (const auto& Pair : Entries)
+	{
+		if (UHenetSerialConnection* Connection = Pair.Value.Connection.Get())
+		{
+			Visitor(*Connection);
+		}
+	}
+}
+
+void FHenetConnectionRegistry::Shutdown()
+{
+	if (LingerTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(LingerTickerHandle);
+		LingerTickerHandle.Reset();
+	}
+
+	for (auto& Pair : Entries)
+	{
+		CloseEntry(Pair.Value);
+	}
+	Entries.Empty();
+}
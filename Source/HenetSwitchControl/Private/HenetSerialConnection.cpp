@@ -5,39 +5,262 @@
 #include "HenetSerialConnection.h"
 #include "HenetSerialPortReader.h"
 #include "HenetSwitchControlModule.h" // For logging
+#include "HenetSwitchDispatchSubsystem.h"
+#include "HenetConnectionRegistry.h"
+#include "HAL/PlatformTime.h"
+#include "Async/Async.h"
 
 UHenetSerialConnection::UHenetSerialConnection()
 {
 	Worker = nullptr;
 }
 
-void UHenetSerialConnection::Open(const FString& PortName)
+void UHenetSerialConnection::Open(const FString& InPortName)
 {
-	if (Worker)
+	if (IsOpen())
 	{
 		UE_LOG(LogHenetSwitchControl, Warning, TEXT("UHenetSerialConnection::Open called, but connection is already open."));
 		return;
 	}
 
+	PortName = InPortName;
+
+	const EHenetClusterRole ClusterRole = FHenetClusterSync::GetConfiguredRole();
+	if (ClusterRole != EHenetClusterRole::Off)
+	{
+		ClusterSync = MakeUnique<FHenetClusterSync>(ClusterRole, PortName);
+		if (!ClusterSync->Open())
+		{
+			UE_LOG(LogHenetSwitchControl, Warning, TEXT("UHenetSerialConnection: Cluster sync unavailable for %s; events stay local to this node."), *PortName);
+		}
+	}
+
+	if (ClusterRole == EHenetClusterRole::Peer)
+	{
+		// The switch box is attached to the owner node; this one only mirrors its events.
+		UE_LOG(LogHenetSwitchControl, Log, TEXT("UHenetSerialConnection: Opening %s as a cluster peer (no local port)."), *PortName);
+		BeginDispatch();
+		return;
+	}
+
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("UHenetSerialConnection: Opening connection to %s..."), *PortName);
+	StartWorker(nullptr);
+}
+
+void UHenetSerialConnection::OpenReplay(const FString& CapturePath, double PlaybackRate)
+{
+	if (IsOpen())
+	{
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("UHenetSerialConnection::OpenReplay called, but connection is already open."));
+		return;
+	}
+
+	// The capture path stands in for the port name in logs and traces.
+	PortName = CapturePath;
+
+	FHenetReplayOptions ReplayOptions;
+	ReplayOptions.CapturePath = CapturePath;
+	ReplayOptions.PlaybackRate = PlaybackRate;
+
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("UHenetSerialConnection: Opening replay of %s..."), *CapturePath);
+	StartWorker(&ReplayOptions);
+}
+
+void UHenetSerialConnection::OpenAggregate(const TArray<FHenetAggregateDevice>& Devices, double ReorderWindowSeconds)
+{
+	if (IsOpen())
+	{
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("UHenetSerialConnection::OpenAggregate called, but connection is already open."));
+		return;
+	}
+
+	if (Devices.Num() == 0)
+	{
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("UHenetSerialConnection::OpenAggregate called without any devices."));
+		return;
+	}
+
+	// Cluster peers have no reader to take events from, and on the owner the merged stream
+	// would skip the frame hold that keeps all nodes applying an event in the same frame.
+	if (FHenetClusterSync::GetConfiguredRole() != EHenetClusterRole::Off)
+	{
+		UE_LOG(LogHenetSwitchControl, Error, TEXT("UHenetSerialConnection::OpenAggregate: aggregate connections are not supported with cluster sync (henet.Cluster.Role). The connection stays closed."));
+		return;
+	}
+
+	FHenetConnectionRegistry& Registry = FHenetSwitchControlModule::Get().GetConnectionRegistry();
+
+	TArray<FString> PortNames;
+	for (const FHenetAggregateDevice& DeviceConfig : Devices)
+	{
+		UHenetSerialConnection* Device = Registry.Acquire(DeviceConfig.PortName);
+		FAggregateSource& Source = AggregateSources.AddDefaulted_GetRef();
+		Source.Connection = Device;
+		Source.SwitchOffset = DeviceConfig.SwitchOffset;
+		Source.Queue = MakeShared<TQueue<FHenetSwitchEvent, EQueueMode::Spsc>, ESPMode::ThreadSafe>();
+
+		// Each device's reader is the only producer of its queue. Status events are combined
+		// into one aggregate state instead (see MergeAggregateSources).
+		Source.CallbackHandle = Device->RegisterWorkerCallback([Queue = Source.Queue](const FHenetSwitchEvent& Event)
+		{
+			if (!Event.bIsConnectionStatus)
+			{
+				Queue->Enqueue(Event);
+			}
+		});
+
+		if (!Source.CallbackHandle.IsValid())
+		{
+			UE_LOG(LogHenetSwitchControl, Warning, TEXT("UHenetSerialConnection: %s has no local reader; its events will not reach the aggregate."), *DeviceConfig.PortName);
+		}
+		PortNames.Add(DeviceConfig.PortName);
+	}
+
+	PortName = FString::Printf(TEXT("Aggregate(%s)"), *FString::Join(PortNames, TEXT("+")));
+	AggregateReorderWindowSeconds = FMath::Max(ReorderWindowSeconds, 0.0);
+	bAggregateConnected = false;
+
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("UHenetSerialConnection: Opened %s with a %.1f ms reorder window."), *PortName, AggregateReorderWindowSeconds * 1000.0);
+	BeginDispatch();
+}
+
+void UHenetSerialConnection::CloseAggregateSources()
+{
+	FHenetSwitchControlModule* Module = FModuleManager::GetModulePtr<FHenetSwitchControlModule>(TEXT("HenetSwitchControl"));
+	for (FAggregateSource& Source : AggregateSources)
+	{
+		if (UHenetSerialConnection* Device = Source.Connection.Get())
+		{
+			Device->UnregisterWorkerCallback(Source.CallbackHandle);
+
+			// During module shutdown the registry closes every device itself.
+			if (Module && Module->HasConnectionRegistry())
+			{
+				Module->GetConnectionRegistry().Release(Device);
+			}
+		}
+	}
+	AggregateSources.Empty();
+}
+
+void UHenetSerialConnection::MergeAggregateSources(TArray<FHenetSwitchEvent>& OutEvents)
+{
+	const uint64 WindowCycles = static_cast<uint64>(AggregateReorderWindowSeconds / FPlatformTime::GetSecondsPerCycle64());
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+	const uint64 HorizonCycles = NowCycles > WindowCycles ? NowCycles - WindowCycles : 0;
+
+	// k-way merge: every device queue is already in timestamp order, so repeatedly take the
+	// earliest head. k is the number of devices, a handful, so a linear scan beats a heap.
+	for (;;)
+	{
+		int32 BestIndex = INDEX_NONE;
+		const FHenetSwitchEvent* BestHead = nullptr;
+		bool bEveryDeviceHasHead = true;
+
+		for (int32 Index = 0; Index < AggregateSources.Num(); ++Index)
+		{
+			const FHenetSwitchEvent* Head = AggregateSources[Index].Queue->Peek();
+			if (!Head)
+			{
+				bEveryDeviceHasHead = false;
+			}
+			else if (!BestHead || Head->TimestampCycles < BestHead->TimestampCycles)
+			{
+				BestIndex = Index;
+				BestHead = Head;
+			}
+		}
+
+		// A device with nothing queued could still produce something earlier, unless the
+		// candidate has already waited out the reorder window.
+		if (!BestHead || (!bEveryDeviceHasHead && BestHead->TimestampCycles > HorizonCycles))
+		{
+			break;
+		}
+
+		FHenetSwitchEvent Event;
+		AggregateSources[BestIndex].Queue->Dequeue(Event);
+		if (!Event.bIsHeartbeat)
+		{
+			Event.SwitchNumber += AggregateSources[BestIndex].SwitchOffset;
+			OutEvents.Add(Event);
+			continue;
+		}
+
+		// Every device beats on its own; the aggregate beats once all of them have, so listeners
+		// get one heartbeat per period that means "every device is alive".
+		AggregateSources[BestIndex].bHeartbeatSeen = true;
+		if (!AggregateSources.ContainsByPredicate([](const FAggregateSource& Source) { return !Source.bHeartbeatSeen; }))
+		{
+			for (FAggregateSource& Source : AggregateSources)
+			{
+				Source.bHeartbeatSeen = false;
+			}
+			OutEvents.Add(Event);
+		}
+	}
+
+	bool bAllConnected = true;
+	for (const FAggregateSource& Source : AggregateSources)
+	{
+		const UHenetSerialConnection* Device = Source.Connection.Get();
+		bAllConnected &= Device && Device->IsConnected();
+	}
+
+	if (bAllConnected != bAggregateConnected)
+	{
+		bAggregateConnected = bAllConnected;
+		OutEvents.Add(FHenetSwitchEvent::MakeConnectionStatus(bAllConnected));
+	}
+}
+
+void UHenetSerialConnection::StartWorker(const FHenetReplayOptions* ReplayOptions)
+{
+	// The FHenetSerialPortReader constructor spawns the thread.
+	// We pass it *our* event queue for it to push events to.
+	Worker = new FHenetSerialPortReader(PortName, EventQueue, ReplayOptions);
+	UpdateReaderInterest();
+	BeginDispatch();
+}
+
+void UHenetSerialConnection::BeginDispatch()
+{
 	// --- NEW: Protect this object from the Garbage Collector ---
 	// This prevents the "Connection object is invalid" error.
 	AddToRoot();
 	// --- End of new code ---
 
-	UE_LOG(LogHenetSwitchControl, Log, TEXT("UHenetSerialConnection: Opening connection to %s..."), *PortName);
-	// The FHenetSerialPortReader constructor spawns the thread.
-	// We pass it *our* event queue for it to push events to.
-	Worker = new FHenetSerialPortReader(PortName, EventQueue);
+	// Have the events pumped once per frame. If the engine is not up yet, the subsystem
+	// picks this connection up when it initializes.
+	if (UHenetSwitchDispatchSubsystem* Dispatcher = UHenetSwitchDispatchSubsystem::Get())
+	{
+		Dispatcher->AddConnection(this);
+	}
 }
 
 void UHenetSerialConnection::Close()
 {
-	if (Worker)
+	if (Worker || ClusterSync || IsAggregate())
 	{
 		UE_LOG(LogHenetSwitchControl, Log, TEXT("UHenetSerialConnection: Closing connection..."));
-		Worker->EnsureCompletion();
-		delete Worker;
-		Worker = nullptr;
+		if (Worker)
+		{
+			Worker->EnsureCompletion();
+			delete Worker;
+			Worker = nullptr;
+		}
+		ClusterSync.Reset();
+		CloseAggregateSources();
+		StopPreRoll();
+
+		// Done after the worker is gone so that continuations which immediately wait again
+		// get an already-closed result instead of a wait that can never fire.
+		ResolveAllEdgeWaits(EHenetWaitResult::Closed);
+
+		if (UHenetSwitchDispatchSubsystem* Dispatcher = UHenetSwitchDispatchSubsystem::Get())
+		{
+			Dispatcher->RemoveConnection(this);
+		}
 
 		// --- NEW: Allow the Garbage Collector to clean up this object ---
 		RemoveFromRoot();
@@ -45,10 +268,463 @@ void UHenetSerialConnection::Close()
 	}
 }
 
+void UHenetSerialConnection::AddListener(IHenetSwitchEventListener* Listener, uint32 InterestMask)
+{
+	if (!Listener)
+	{
+		return;
+	}
+
+	if (Listeners.ContainsByPredicate([Listener](const FListenerEntry& Entry) { return Entry.Listener == Listener; }))
+	{
+		SetListenerInterest(Listener, InterestMask);
+		return;
+	}
+
+	Listeners.Add({ Listener, InterestMask });
+	AddInterest(InterestMask);
+}
+
+void UHenetSerialConnection::SetListenerInterest(IHenetSwitchEventListener* Listener, uint32 InterestMask)
+{
+	FListenerEntry* Entry = Listeners.FindByPredicate([Listener](const FListenerEntry& Candidate) { return Candidate.Listener == Listener; });
+	if (!Entry || Entry->InterestMask == InterestMask)
+	{
+		return;
+	}
+
+	// Add before removing so shared bits never briefly drop to zero on the reader.
+	AddInterest(InterestMask);
+	RemoveInterest(Entry->InterestMask);
+	Entry->InterestMask = InterestMask;
+}
+
+void UHenetSerialConnection::RemoveListener(IHenetSwitchEventListener* Listener)
+{
+	const int32 Index = Listeners.IndexOfByPredicate([Listener](const FListenerEntry& Entry) { return Entry.Listener == Listener; });
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	RemoveInterest(Listeners[Index].InterestMask);
+
+	if (bDispatching)
+	{
+		// Keep indices stable for the loop in DispatchPendingEvents; compacted when it finishes.
+		Listeners[Index].Listener = nullptr;
+	}
+	else
+	{
+		Listeners.RemoveAt(Index);
+	}
+}
+
+void UHenetSerialConnection::EnablePreRoll(int32 MaxEvents, double MaxAgeSeconds)
+{
+	if (Listeners.Num() > 0 || MaxEvents <= 0)
+	{
+		return;
+	}
+
+	PreRollMaxEvents = MaxEvents;
+	PreRollMaxAgeSeconds = MaxAgeSeconds;
+	if (!bPreRollActive)
+	{
+		// With no listener the reader's interest is empty and it would drop everything.
+		bPreRollActive = true;
+		AddInterest(HenetInterest::All);
+	}
+}
+
+void UHenetSerialConnection::TrimPreRoll()
+{
+	int32 NumToDrop = FMath::Max(0, PreRollEvents.Num() - PreRollMaxEvents);
+
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+	while (NumToDrop < PreRollEvents.Num()
+		&& FPlatformTime::ToSeconds64(NowCycles - PreRollEvents[NumToDrop].TimestampCycles) > PreRollMaxAgeSeconds)
+	{
+		++NumToDrop;
+	}
+
+	PreRollEvents.RemoveAt(0, NumToDrop, EAllowShrinking::No);
+}
+
+void UHenetSerialConnection::StopPreRoll()
+{
+	if (bPreRollActive)
+	{
+		bPreRollActive = false;
+		RemoveInterest(HenetInterest::All);
+	}
+	PreRollEvents.Empty();
+}
+
+void UHenetSerialConnection::AddInterest(uint32 InterestMask)
+{
+	for (int32 Bit = 0; Bit < 32; ++Bit)
+	{
+		if (InterestMask & (1u << Bit))
+		{
+			++InterestCounts[Bit];
+		}
+	}
+	UpdateReaderInterest();
+}
+
+void UHenetSerialConnection::RemoveInterest(uint32 InterestMask)
+{
+	for (int32 Bit = 0; Bit < 32; ++Bit)
+	{
+		if ((InterestMask & (1u << Bit)) && ensure(InterestCounts[Bit] > 0))
+		{
+			--InterestCounts[Bit];
+		}
+	}
+	UpdateReaderInterest();
+}
+
+void UHenetSerialConnection::UpdateReaderInterest()
+{
+	uint32 Mask = HenetInterest::None;
+	for (int32 Bit = 0; Bit < 32; ++Bit)
+	{
+		if (InterestCounts[Bit] > 0)
+		{
+			Mask |= (1u << Bit);
+		}
+	}
+
+	if (Worker)
+	{
+		// Peers have interests of their own that this node cannot see, so an owner forwards everything.
+		const bool bClusterOwner = ClusterSync && ClusterSync->GetRole() == EHenetClusterRole::Owner;
+		Worker->SetInterestMask(bClusterOwner ? HenetInterest::All : Mask);
+	}
+}
+
+void UHenetSerialConnection::DispatchPendingEvents()
+{
+	PendingEvents.Reset();
+
+	FHenetSwitchEvent Event;
+	while (EventQueue.Dequeue(Event))
+	{
+		PendingEvents.Add(Event);
+	}
+
+	if (IsAggregate())
+	{
+		MergeAggregateSources(PendingEvents);
+	}
+
+	// In a cluster the batch is swapped for the events due in this frame on every node.
+	if (ClusterSync)
+	{
+		ClusterSync->Process(PendingEvents, Worker && Worker->IsConnected());
+	}
+
+	// Waits need the per-frame tick for their timeouts even when nothing arrived.
+	if (EdgeWaits.Num() > 0)
+	{
+		ResolveEdgeWaits(PendingEvents);
+	}
+
+	if (bPreRollActive)
+	{
+		if (Listeners.Num() == 0)
+		{
+			// Nobody is attached yet: keep the events for the first listener instead of dropping them.
+			PreRollEvents.Append(PendingEvents);
+			TrimPreRoll();
+			return;
+		}
+
+		// The first listener gets what it missed, oldest first, then pre-roll ends.
+		TrimPreRoll();
+		if (PreRollEvents.Num() > 0)
+		{
+			UE_LOG(LogHenetSwitchControl, Log, TEXT("UHenetSerialConnection: Delivering %d pre-roll event(s) from %s."), PreRollEvents.Num(), *PortName);
+			PendingEvents.Insert(PreRollEvents, 0);
+		}
+		StopPreRoll();
+	}
+
+	if (PendingEvents.Num() == 0)
+	{
+		return;
+	}
+
+	// Listeners added during dispatch start with the next frame's batch.
+	bDispatching = true;
+	const int32 NumListeners = Listeners.Num();
+	for (int32 Index = 0; Index < NumListeners; ++Index)
+	{
+		if (IHenetSwitchEventListener* Listener = Listeners[Index].Listener)
+		{
+			// The batch is the union of everybody's interest; listeners filter their own view
+			// with FHenetSwitchEvent::MatchesInterest if they care.
+			Listener->HandleHenetEvents(this, PendingEvents);
+		}
+	}
+	bDispatching = false;
+
+	Listeners.RemoveAll([](const FListenerEntry& Entry) { return Entry.Listener == nullptr; });
+}
+
+FHenetLinkStats UHenetSerialConnection::GetLinkStats() const
+{
+	FHenetLinkStats Stats;
+	if (!Worker)
+	{
+		return Stats;
+	}
+
+	const FHenetLinkCounters Counters = Worker->GetLinkCounters();
+	Stats.FramesReceived = Counters.FramesReceived;
+	Stats.FramesCorrupt = Counters.FramesCorrupt;
+	Stats.FramesLost = Counters.FramesLost;
+	Stats.FramesRecovered = Counters.FramesRecovered;
+	Stats.ParseErrors = Counters.ParseErrors;
+	Stats.bProtocolV2 = Counters.bProtocolV2;
+
+	const int32 Expected = Counters.FramesReceived + Counters.FramesLost;
+	Stats.LossRate = Expected > 0 ? static_cast<float>(Counters.FramesLost) / Expected : 0.0f;
+
+	const int32 Seen = Counters.FramesReceived + Counters.FramesCorrupt;
+	Stats.CorruptionRate = Seen > 0 ? static_cast<float>(Counters.FramesCorrupt) / Seen : 0.0f;
+	return Stats;
+}
+
+TFuture<EHenetWaitResult> UHenetSerialConnection::NextEdge(int32 SwitchNumber, bool bPressed, double TimeoutSeconds)
+{
+	check(IsInGameThread());
+
+	if (SwitchNumber < 1 || SwitchNumber > HenetInterest::MaxSwitchNumber || !IsOpen())
+	{
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("NextEdge: Connection is not open or switch %d is out of range."), SwitchNumber);
+		return MakeFulfilledPromise<EHenetWaitResult>(EHenetWaitResult::Closed).GetFuture();
+	}
+
+	FPendingEdgeWait& Wait = EdgeWaits.AddDefaulted_GetRef();
+	Wait.InterestBit = HenetInterest::SwitchEdge(SwitchNumber, bPressed);
+	Wait.Deadline = TimeoutSeconds > 0.0 ? FPlatformTime::Seconds() + TimeoutSeconds : 0.0;
+
+	// Make sure the reader queues this edge even if no listener asked for it.
+	AddInterest(Wait.InterestBit);
+	return Wait.Promise.GetFuture();
+}
+
+void UHenetSerialConnection::ResolveEdgeWaits(TConstArrayView<FHenetSwitchEvent> Events)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	// Continuations run synchronously inside SetValue and may start new waits (appended past
+	// NumWaits, so they only see later edges) or even close the connection.
+	int32 NumWaits = EdgeWaits.Num();
+	for (int32 Index = 0; Index < NumWaits; )
+	{
+		const uint32 InterestBit = EdgeWaits[Index].InterestBit;
+		const double Deadline = EdgeWaits[Index].Deadline;
+
+		const bool bTriggered = Events.ContainsByPredicate([InterestBit](const FHenetSwitchEvent& Event)
+		{
+			return Event.GetInterestBit() == InterestBit;
+		});
+		const bool bTimedOut = !bTriggered && Deadline > 0.0 && Now >= Deadline;
+
+		if (!bTriggered && !bTimedOut)
+		{
+			++Index;
+			continue;
+		}
+
+		// Take the wait out before fulfilling it so re-entrant calls see a consistent array.
+		TPromise<EHenetWaitResult> Promise = MoveTemp(EdgeWaits[Index].Promise);
+		EdgeWaits.RemoveAt(Index, 1, EAllowShrinking::No);
+		RemoveInterest(InterestBit);
+
+		Promise.SetValue(bTriggered ? EHenetWaitResult::Triggered : EHenetWaitResult::TimedOut);
+		NumWaits = FMath::Min(NumWaits - 1, EdgeWaits.Num());
+	}
+}
+
+void UHenetSerialConnection::ResolveAllEdgeWaits(EHenetWaitResult Result)
+{
+	// Swap out first; continuations may start new waits while we fulfil these.
+	TArray<FPendingEdgeWait> Waits = MoveTemp(EdgeWaits);
+	EdgeWaits.Reset();
+
+	for (FPendingEdgeWait& Wait : Waits)
+	{
+		RemoveInterest(Wait.InterestBit);
+		Wait.Promise.SetValue(Result);
+	}
+}
+
+FDelegateHandle UHenetSerialConnection::RegisterWorkerCallback(FHenetWorkerCallback Callback, uint32 InterestMask)
+{
+	if (!Worker)
+	{
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("RegisterWorkerCallback: Connection is not open."));
+		return FDelegateHandle();
+	}
+	return Worker->GetWorkerCallbacks().Add(MoveTemp(Callback), InterestMask);
+}
+
+bool UHenetSerialConnection::UnregisterWorkerCallback(FDelegateHandle Handle)
+{
+	return Worker && Worker->GetWorkerCallbacks().Remove(Handle);
+}
+
+int32 UHenetSerialConnection::LogTrace(int32 MaxRecords, bool bOnlyNew, bool bFormatAsync)
+{
+	if (!Worker)
+	{
+		return 0;
+	}
+
+	TraceRecords.Reset();
+	const uint64 FromIndex = bOnlyNew ? TraceReadIndex : 0;
+	TraceReadIndex = Worker->GetTrace().Read(FromIndex, TraceRecords);
+
+	const int32 First = (MaxRecords > 0) ? FMath::Max(0, TraceRecords.Num() - MaxRecords) : 0;
+	if (First >= TraceRecords.Num())
+	{
+		return 0;
+	}
+
+	const int32 NumRecords = TraceRecords.Num() - First;
+	if (bFormatAsync)
+	{
+		// The task owns its copy; this connection may be gone by the time it runs.
+		AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask,
+			[Records = TArray<FHenetTraceRecord>(TraceRecords.GetData() + First, NumRecords), Port = PortName]()
+		{
+			LogTraceRecords(Port, Records);
+		});
+	}
+	else
+	{
+		LogTraceRecords(PortName, TConstArrayView<FHenetTraceRecord>(TraceRecords.GetData() + First, NumRecords));
+	}
+	return NumRecords;
+}
+
+void UHenetSerialConnection::LogTraceRecords(const FString& Port, TConstArrayView<FHenetTraceRecord> Records)
+{
+	const uint64 BaseCycles = Records[0].Cycles;
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("Trace for %s (%d records):"), *Port, Records.Num());
+	for (const FHenetTraceRecord& Record : Records)
+	{
+		UE_LOG(LogHenetSwitchControl, Log, TEXT("  %s"), *FHenetSerialPortReader::FormatTraceRecord(Record, BaseCycles));
+	}
+}
+
+bool UHenetSerialConnection::IsReplay() const
+{
+	return Worker && Worker->IsReplay();
+}
+
+bool UHenetSerialConnection::StartCapture(const FString& FileName, FString& OutFilePath)
+{
+	OutFilePath.Reset();
+	if (!Worker)
+	{
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("StartCapture: connection is not open."));
+		return false;
+	}
+
+	const FString FilePath = FHenetCaptureWriter::ResolvePath(FileName, IsReplay() ? TEXT("Replay") : PortName);
+	if (!Worker->StartCapture(FilePath))
+	{
+		return false;
+	}
+
+	OutFilePath = FilePath;
+	return true;
+}
+
+void UHenetSerialConnection::StopCapture()
+{
+	if (Worker)
+	{
+		Worker->StopCapture();
+	}
+}
+
+bool UHenetSerialConnection::HasReaderStopped() const
+{
+	return Worker && Worker->HasStopped();
+}
+
+void UHenetSerialConnection::RestartReader()
+{
+	if (!Worker || Worker->IsReplay())
+	{
+		return;
+	}
+
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("UHenetSerialConnection: Restarting reader for %s..."), *PortName);
+
+	FHenetSerialPortReader* OldWorker = Worker;
+	OldWorker->EnsureCompletion();
+	Worker = new FHenetSerialPortReader(PortName, EventQueue, nullptr, OldWorker);
+	delete OldWorker;
+
+	// The new reader starts with an empty trace ring.
+	TraceReadIndex = 0;
+	UpdateReaderInterest();
+}
+
+bool UHenetSerialConnection::IsConnected() const
+{
+	if (IsAggregate())
+	{
+		return bAggregateConnected;
+	}
+	if (!Worker && ClusterSync)
+	{
+		return ClusterSync->IsOwnerConnected();
+	}
+	return Worker && Worker->IsConnected();
+}
+
 void UHenetSerialConnection::BeginDestroy()
 {
 	// This ensures the thread is cleaned up if the object is garbage collected.
 	UE_LOG(LogHenetSwitchControl, Log, TEXT("UHenetSerialConnection: BeginDestroy called, ensuring connection is closed."));
 	Close();
 	Super::BeginDestroy();
-}
\ No newline at end of file
+}
+
+void UHenetSerialConnection::ConfigureAnalogChannel(int32 Channel, int32 Decimation, float Smoothing)
+{
+	FHenetAnalogChannel* AnalogChannel = Worker ? Worker->GetAnalogChannel(Channel) : nullptr;
+	if (!AnalogChannel)
+	{
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("ConfigureAnalogChannel: Connection is not open or channel %d is out of range."), Channel);
+		return;
+	}
+
+	AnalogChannel->Configure(Decimation, Smoothing);
+}
+
+float UHenetSerialConnection::GetAnalogValue(int32 Channel) const
+{
+	const FHenetAnalogChannel* AnalogChannel = Worker ? Worker->GetAnalogChannel(Channel) : nullptr;
+	return AnalogChannel ? AnalogChannel->GetLatestValue() : 0.0f;
+}
+
+int32 UHenetSerialConnection::ConsumeAnalogSamples(int32 Channel, TArray<float>& OutSamples)
+{
+	FHenetAnalogChannel* AnalogChannel = Worker ? Worker->GetAnalogChannel(Channel) : nullptr;
+	if (!AnalogChannel)
+	{
+		OutSamples.Reset();
+		return 0;
+	}
+
+	return AnalogChannel->ConsumeSamples(OutSamples);
+}
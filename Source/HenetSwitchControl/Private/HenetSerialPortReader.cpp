@@ -6,6 +6,8 @@
 #include "HAL/RunnableThread.h"
 #include "Logging/LogMacros.h"
 #include "HenetSwitchControlModule.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
 
 // Conditionally include Windows headers only on Windows
 #if PLATFORM_WINDOWS && HENET_WINDOWS_SERIAL
@@ -13,20 +15,101 @@
 #else
 // Define placeholder types if not on Windows to allow compilation
 typedef void* HANDLE;
-#define INVALID_HANDLE_VALUE ((HANDLE)(LONG_PTR)-1)
+#define INVALID_HANDLE_VALUE ((HANDLE)(UPTRINT)-1)
 typedef struct _DCB { uint32 DCBlength; } DCB;
 typedef struct _COMMTIMEOUTS { uint32 ReadIntervalTimeout; } COMMTIMEOUTS;
 #endif
 
-FHenetSerialPortReader::FHenetSerialPortReader(const FString& InPortName, TQueue<FHenetSwitchEvent, EQueueMode::Mpsc>& InEventQueue)
+static int32 GHenetRequestProtocolV2 = 1;
+static FAutoConsoleVariableRef CVarHenetRequestProtocolV2(
+    TEXT("henet.RequestProtocolV2"),
+    GHenetRequestProtocolV2,
+    TEXT("If set, the reader asks the device to switch to v2 framing (sequence number + CRC) when the port opens. v1 devices ignore the request."),
+    ECVF_Default);
+
+static int32 GHenetSharedStateExport = 1;
+static FAutoConsoleVariableRef CVarHenetSharedStateExport(
+    TEXT("henet.SharedStateExport"),
+    GHenetSharedStateExport,
+    TEXT("If set, each reader publishes live switch state to a named shared memory segment (HenetSwitchControl_<Port>) for external processes. Read when a port opens."),
+    ECVF_Default);
+
+static int32 GHenetRequestRetransmit = 1;
+static FAutoConsoleVariableRef CVarHenetRequestRetransmit(
+    TEXT("henet.RequestRetransmit"),
+    GHenetRequestRetransmit,
+    TEXT("If set, the reader asks a v2 device to resend frames it detects as missing from the sequence."),
+    ECVF_Default);
+
+/** Upper bound on retransmission requests sent for a single gap, so a long outage doesn't flood the device. */
+static constexpr int32 MaxRetransmitRequestsPerGap = 8;
+
+/** A forward jump this large is a device that restarted its numbering, not frames lost on a 9600 baud line. */
+static constexpr uint8 ResyncGapFrames = 64;
+
+/** This many consecutive frames, each following the previous one but all behind, mean the device restarted its numbering. */
+static constexpr int32 ResyncBehindRun = 3;
+
+/** Duplicates and late retransmissions arrive within this many frames of the newest one. */
+static constexpr uint8 DuplicateWindowFrames = 16;
+
+FHenetSerialPortReader::FHenetSerialPortReader(const FString& InPortName, TQueue<FHenetSwitchEvent, EQueueMode::Mpsc>& InEventQueue,
+    const FHenetReplayOptions* InReplayOptions, const FHenetSerialPortReader* InPrevious)
     : PortName(InPortName)
     , EventQueue(InEventQueue)
     , StopTaskCounter(0)
+    , CurrentReadCycles(0)
+    , CurrentByteCycles(0)
+    , ByteDurationCycles(static_cast<uint64>((10.0 / BaudRate) / FPlatformTime::GetSecondsPerCycle64()))
+    , InterestMask(HenetInterest::All)
+    , bConnected(false)
     , hSerial(INVALID_HANDLE_VALUE)
     , ParserState(EParserState::Find_ENQ)
+    , TempMessageType(0)
     , TempSwitchNum(0)
     , TempEventType(0)
+    , TempAnalogChannel(0)
+    , TempAnalogValue(0)
+    , TempAnalogDigits(0)
+    , bTempIsV2Frame(false)
+    , bTempIsRecovered(false)
+    , TempSequence(0)
+    , TempChecksum(0)
+    , TempHexDigits(0)
+    , RunningCrc(0)
+    , bHaveSequence(false)
+    , ExpectedSequence(0)
+    , BehindRunLength(0)
+    , BehindRunNext(0)
+    , FramesReceived(0)
+    , FramesCorrupt(0)
+    , FramesLost(0)
+    , FramesRecovered(0)
+    , ParseErrors(0)
+    , bLinkIsV2(false)
+    , bIsReplay(InReplayOptions != nullptr)
+    , bCaptureCommandPending(false)
 {
+    if (InReplayOptions)
+    {
+        ReplayOptions = *InReplayOptions;
+    }
+
+    FMemory::Memzero(MissingSequences, sizeof(MissingSequences));
+    for (int32& Sequence : LastEdgeSequence)
+    {
+        Sequence = -1;
+    }
+
+    if (InPrevious)
+    {
+        for (int32 Index = 0; Index < NumAnalogChannels; ++Index)
+        {
+            AnalogChannels[Index].CopyConfiguration(InPrevious->AnalogChannels[Index]);
+        }
+        WorkerCallbacks.CopyFrom(InPrevious->WorkerCallbacks);
+    }
+
     // Create the thread
     Thread = FRunnableThread::Create(this, TEXT("HenetSerialPortReaderThread"), 0, TPri_BelowNormal);
 }
@@ -45,6 +128,26 @@ FHenetSerialPortReader::~FHenetSerialPortReader()
 bool FHenetSerialPortReader::Init()
 {
     UE_LOG(LogHenetSwitchControl, Log, TEXT("Serial reader thread initializing..."));
+
+    if (bIsReplay)
+    {
+        // Replay runs the same parser on any platform; there is no device to talk to, and
+        // the shared-memory export is left alone so a replay never masks a live port.
+        Replay = MakeUnique<FHenetCaptureReader>();
+        if (!Replay->Open(ReplayOptions.CapturePath))
+        {
+            Replay.Reset();
+            DeliverEvent(FHenetSwitchEvent::MakeConnectionStatus(false));
+            MarkThreadFinished();
+            return false;
+        }
+
+        UE_LOG(LogHenetSwitchControl, Log, TEXT("Replaying capture %s (%s)."), *ReplayOptions.CapturePath,
+            ReplayOptions.PlaybackRate > 0.0 ? *FString::Printf(TEXT("x%.2f"), ReplayOptions.PlaybackRate) : TEXT("max speed"));
+        bConnected.store(true);
+        DeliverEvent(FHenetSwitchEvent::MakeConnectionStatus(true));
+        return true;
+    }
     
 #if PLATFORM_WINDOWS && HENET_WINDOWS_SERIAL
     // Try to open the serial port
@@ -53,7 +156,7 @@ bool FHenetSerialPortReader::Init()
     
     hSerial = CreateFile(
         *FullPortName,
-        GENERIC_READ,
+        GENERIC_READ | GENERIC_WRITE, // Write is used for v2 negotiation and retransmission requests
         0,
         NULL,
         OPEN_EXISTING,
@@ -65,7 +168,8 @@ bool FHenetSerialPortReader::Init()
     {
         DWORD LastError = GetLastError();
         UE_LOG(LogHenetSwitchControl, Error, TEXT("Failed to open serial port %s. Error code: %d"), *PortName, LastError);
-        EventQueue.Enqueue(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
+        DeliverEvent(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
+        MarkThreadFinished(); // Run() is skipped when Init() fails, so flag the stop here
         return false;
     }
 
@@ -78,11 +182,12 @@ bool FHenetSerialPortReader::Init()
         UE_LOG(LogHenetSwitchControl, Error, TEXT("Failed to get serial port state."));
         CloseHandle(hSerial);
         hSerial = INVALID_HANDLE_VALUE;
-        EventQueue.Enqueue(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
+        DeliverEvent(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
+        MarkThreadFinished();
         return false;
     }
 
-    dcbSerialParams.BaudRate = CBR_9600;
+    dcbSerialParams.BaudRate = BaudRate;
     dcbSerialParams.ByteSize = 8;
     dcbSerialParams.Parity = NOPARITY;
     dcbSerialParams.StopBits = ONESTOPBIT;
@@ -99,7 +204,8 @@ bool FHenetSerialPortReader::Init()
         UE_LOG(LogHenetSwitchControl, Error, TEXT("Failed to set serial port state."));
         CloseHandle(hSerial);
         hSerial = INVALID_HANDLE_VALUE;
-        EventQueue.Enqueue(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
+        DeliverEvent(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
+        MarkThreadFinished();
         return false;
     }
     
@@ -130,12 +236,17 @@ bool FHenetSerialPortReader::Init()
     timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
     // --- End of modification ---
 
+    // Our writes are a handful of bytes; never let a stalled device block the reader for long.
+    timeouts.WriteTotalTimeoutConstant = 50;
+    timeouts.WriteTotalTimeoutMultiplier = 0;
+
     if (!SetCommTimeouts(hSerial, &timeouts))
     {
         UE_LOG(LogHenetSwitchControl, Error, TEXT("Failed to set serial port timeouts."));
         CloseHandle(hSerial);
         hSerial = INVALID_HANDLE_VALUE;
-        EventQueue.Enqueue(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
+        DeliverEvent(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
+        MarkThreadFinished();
         return false;
     }
     else
@@ -145,18 +256,40 @@ bool FHenetSerialPortReader::Init()
     }
 
     UE_LOG(LogHenetSwitchControl, Log, TEXT("Successfully opened and configured serial port %s."), *PortName);
-    EventQueue.Enqueue(FHenetSwitchEvent::MakeConnectionStatus(true)); // <-- NEW
+
+    if (GHenetRequestProtocolV2)
+    {
+        // Capability request. A v2 device answers by switching to v2 frames, which we
+        // detect on the first one received; a v1 device ignores it.
+        const uint8 Hello[] = { EProtocolChars::Proto_V };
+        WriteFrame(Hello, UE_ARRAY_COUNT(Hello));
+    }
+
+    if (GHenetSharedStateExport)
+    {
+        SharedState.Open(PortName);
+    }
+
+    bConnected.store(true);
+    DeliverEvent(FHenetSwitchEvent::MakeConnectionStatus(true)); // <-- NEW
     return true;
 
 #else
     UE_LOG(LogHenetSwitchControl, Warning, TEXT("Serial communication is only supported on Windows."));
-    EventQueue.Enqueue(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
+    DeliverEvent(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
+    MarkThreadFinished();
     return false;
 #endif
 }
 
 uint32 FHenetSerialPortReader::Run()
 {
+    if (bIsReplay)
+    {
+        RunReplay();
+        return 0;
+    }
+
     // Check if initialization failed
     if (hSerial == INVALID_HANDLE_VALUE)
     {
@@ -165,46 +298,40 @@ uint32 FHenetSerialPortReader::Run()
 
     UE_LOG(LogHenetSwitchControl, Log, TEXT("Serial reader thread running..."));
 
+#if PLATFORM_WINDOWS && HENET_WINDOWS_SERIAL
     // Buffer to read data into
     uint8 ReadBuffer[256];
     DWORD BytesRead = 0;
+#endif
 
     // Main thread loop
     while (StopTaskCounter.Load() == 0)
     {
-        // <-- NEW: Added log to see if the loop is spinning -->
-        UE_LOG(LogHenetSwitchControl, VeryVerbose, TEXT("Run() loop spinning..."));
-
 #if PLATFORM_WINDOWS && HENET_WINDOWS_SERIAL
         // Try to read data from the port
-        // <-- NEW: Added log before ReadFile -->
-        UE_LOG(LogHenetSwitchControl, VeryVerbose, TEXT("Calling ReadFile..."));
         if (ReadFile(hSerial, ReadBuffer, sizeof(ReadBuffer), &BytesRead, NULL))
         {
+            ApplyPendingCaptureCommand();
+
             if (BytesRead > 0)
             {
-                // <-- Log level changed to VeryVerbose -->
-                FString HexString = FString::FromHexBlob(ReadBuffer, BytesRead);
-                UE_LOG(LogHenetSwitchControl, VeryVerbose, TEXT("Serial Data Received (%d bytes): %s"), BytesRead, *HexString);
-                // <-- End of change -->
-
-                // Process every byte read
-                for (DWORD i = 0; i < BytesRead; ++i)
-                {
-                    ParseByte(ReadBuffer[i]);
-                }
+                ProcessRead(ReadBuffer, BytesRead);
             }
             else
             {
                 // <-- NEW: Added log for ReadFile returning 0 bytes -->
                 UE_LOG(LogHenetSwitchControl, VeryVerbose, TEXT("ReadFile successful, but BytesRead = 0."));
+
+                // Keep retiring callback snapshots while the line is idle.
+                WorkerCallbacks.Quiesce();
             }
         }
         else
         {
             // ReadFile failed, likely a disconnect
             UE_LOG(LogHenetSwitchControl, Error, TEXT("ReadFile failed. Error code: %d. Stopping thread."), GetLastError());
-            EventQueue.Enqueue(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
+            bConnected.store(false);
+            DeliverEvent(FHenetSwitchEvent::MakeConnectionStatus(false)); // <-- NEW
             StopTaskCounter.Store(1);
         }
 #else
@@ -218,6 +345,121 @@ uint32 FHenetSerialPortReader::Run()
     return 0;
 }
 
+void FHenetSerialPortReader::ProcessRead(const uint8* Bytes, int32 Count)
+{
+    // Raw bytes go to the binary trace instead of a formatted log line; they are only
+    // turned into text on demand (henet.DumpTrace) or by the flusher (henet.TraceFlushInterval).
+    CurrentReadCycles = FPlatformTime::Cycles64();
+    Trace.RecordBytes(Bytes, Count, CurrentReadCycles);
+
+    if (ActiveCapture)
+    {
+        ActiveCapture->Append(CurrentReadCycles, Bytes, Count);
+    }
+
+    // The read returns as soon as bytes are waiting, so completion is close to when the last
+    // byte arrived; earlier bytes in the same read arrived one byte time apart before it.
+    uint64 ByteCycles = CurrentReadCycles - static_cast<uint64>(Count - 1) * ByteDurationCycles;
+
+    // Process every byte read
+    for (int32 i = 0; i < Count; ++i)
+    {
+        CurrentByteCycles = ByteCycles;
+        ParseByte(Bytes[i]);
+        ByteCycles += ByteDurationCycles;
+    }
+
+    // No callback snapshot is held past this point.
+    WorkerCallbacks.Quiesce();
+}
+
+void FHenetSerialPortReader::RunReplay()
+{
+    UE_LOG(LogHenetSwitchControl, Log, TEXT("Replay thread running..."));
+
+    const bool bPaced = ReplayOptions.PlaybackRate > 0.0;
+    const double StartSeconds = FPlatformTime::Seconds();
+    int64 BytesReplayed = 0;
+
+    uint64 RecordMicros = 0;
+    const uint8* Bytes = nullptr;
+    int32 Count = 0;
+    while (StopTaskCounter.Load() == 0 && Replay->Next(RecordMicros, Bytes, Count))
+    {
+        if (bPaced)
+        {
+            // Sleep in short slices so Stop() is honoured even across long idle gaps in the capture.
+            const double DueSeconds = StartSeconds + (RecordMicros / 1000000.0) / ReplayOptions.PlaybackRate;
+            for (double Now = FPlatformTime::Seconds(); Now < DueSeconds && StopTaskCounter.Load() == 0; Now = FPlatformTime::Seconds())
+            {
+                FPlatformProcess::Sleep(static_cast<float>(FMath::Min(DueSeconds - Now, 0.1)));
+            }
+        }
+
+        ApplyPendingCaptureCommand();
+        ProcessRead(Bytes, Count);
+        BytesReplayed += Count;
+    }
+
+    const double ElapsedSeconds = FPlatformTime::Seconds() - StartSeconds;
+    UE_LOG(LogHenetSwitchControl, Log, TEXT("Replay of %s finished: %lld bytes in %.3f s (%.0f bytes/s), %d frames, %d parse errors."),
+        *ReplayOptions.CapturePath, BytesReplayed, ElapsedSeconds, ElapsedSeconds > 0.0 ? BytesReplayed / ElapsedSeconds : 0.0,
+        FramesReceived.Load(EMemoryOrder::Relaxed), ParseErrors.Load(EMemoryOrder::Relaxed));
+
+    // The end of the capture looks like the device going away.
+    bConnected.store(false);
+    DeliverEvent(FHenetSwitchEvent::MakeConnectionStatus(false));
+    StopTaskCounter.Store(1);
+}
+
+bool FHenetSerialPortReader::StartCapture(const FString& FilePath)
+{
+    if (HasStopped() || FilePath.IsEmpty())
+    {
+        return false;
+    }
+
+    FScopeLock Lock(&CaptureLock);
+    PendingCapturePath = FilePath;
+    bCaptureCommandPending.store(true, std::memory_order_release);
+    return true;
+}
+
+void FHenetSerialPortReader::StopCapture()
+{
+    FScopeLock Lock(&CaptureLock);
+    PendingCapturePath.Reset();
+    bCaptureCommandPending.store(true, std::memory_order_release);
+}
+
+void FHenetSerialPortReader::ApplyPendingCaptureCommand()
+{
+    if (!bCaptureCommandPending.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    FString Path;
+    {
+        FScopeLock Lock(&CaptureLock);
+        Path = MoveTemp(PendingCapturePath);
+        PendingCapturePath.Reset();
+        bCaptureCommandPending.store(false, std::memory_order_relaxed);
+    }
+
+    // The file work (closing the old capture, creating the directory and the new file) happens
+    // here on the reader thread, outside the lock, so the game thread never waits on the disk.
+    ActiveCapture.Reset();
+    if (!Path.IsEmpty())
+    {
+        TUniquePtr<FHenetCaptureWriter> Writer = MakeUnique<FHenetCaptureWriter>();
+        if (Writer->Open(Path, BaudRate))
+        {
+            ActiveCapture = MoveTemp(Writer);
+        }
+    }
+}
+
 void FHenetSerialPortReader::Stop()
 {
     // This is called by the FRunnable interface, signals the thread to stop
@@ -235,6 +477,27 @@ void FHenetSerialPortReader::Exit()
         UE_LOG(LogHenetSwitchControl, Log, TEXT("Serial port %s closed."), *PortName);
     }
 #endif
+
+    // Leaves a final "disconnected" state for external readers, then unmaps.
+    SharedState.Close();
+
+    // Flush whatever was captured; a capture requested after the last read is never started.
+    {
+        FScopeLock Lock(&CaptureLock);
+        PendingCapturePath.Reset();
+        bCaptureCommandPending.store(false, std::memory_order_relaxed);
+    }
+    ActiveCapture.Reset();
+    Replay.Reset();
+
+    WorkerCallbacks.ReaderFinished();
+}
+
+void FHenetSerialPortReader::MarkThreadFinished()
+{
+    // Run() and Exit() are skipped when Init() fails, so this is the thread's last word.
+    StopTaskCounter.Store(1);
+    WorkerCallbacks.ReaderFinished();
 }
 
 void FHenetSerialPortReader::EnsureCompletion()
@@ -246,10 +509,258 @@ void FHenetSerialPortReader::EnsureCompletion()
     }
 }
 
+FHenetAnalogChannel* FHenetSerialPortReader::GetAnalogChannel(int32 Channel)
+{
+    if (Channel < 1 || Channel > NumAnalogChannels)
+    {
+        return nullptr;
+    }
+    return &AnalogChannels[Channel - 1];
+}
+
+/** Converts an ASCII hex digit to its value, or returns -1 if the byte is not a hex digit. */
+static int32 HexDigitValue(uint8 Byte)
+{
+    if (Byte >= '0' && Byte <= '9') return Byte - '0';
+    if (Byte >= 'A' && Byte <= 'F') return Byte - 'A' + 10;
+    if (Byte >= 'a' && Byte <= 'f') return Byte - 'a' + 10;
+    return -1;
+}
+
+FHenetLinkCounters FHenetSerialPortReader::GetLinkCounters() const
+{
+    FHenetLinkCounters Counters;
+    Counters.FramesReceived = FramesReceived.Load(EMemoryOrder::Relaxed);
+    Counters.FramesCorrupt = FramesCorrupt.Load(EMemoryOrder::Relaxed);
+    Counters.FramesLost = FramesLost.Load(EMemoryOrder::Relaxed);
+    Counters.FramesRecovered = FramesRecovered.Load(EMemoryOrder::Relaxed);
+    Counters.ParseErrors = ParseErrors.Load(EMemoryOrder::Relaxed);
+    Counters.bProtocolV2 = bLinkIsV2.load(std::memory_order_relaxed);
+    return Counters;
+}
+
+/** CRC-8, polynomial 0x07, no reflection. Bitwise is plenty fast at serial rates. */
+static uint8 Crc8Update(uint8 Crc, uint8 Byte)
+{
+    Crc ^= Byte;
+    for (int32 Bit = 0; Bit < 8; ++Bit)
+    {
+        Crc = (Crc & 0x80) ? static_cast<uint8>((Crc << 1) ^ 0x07) : static_cast<uint8>(Crc << 1);
+    }
+    return Crc;
+}
+
+/** Converts the low nibble of a value to an uppercase ASCII hex digit. */
+static uint8 HexDigitChar(uint8 Value)
+{
+    Value &= 0x0F;
+    return Value < 10 ? static_cast<uint8>('0' + Value) : static_cast<uint8>('A' + Value - 10);
+}
+
+void FHenetSerialPortReader::ResetFrame()
+{
+    TempMessageType = 0;
+    TempSwitchNum = 0;
+    TempEventType = 0;
+    TempAnalogChannel = 0;
+    TempAnalogValue = 0;
+    TempAnalogDigits = 0;
+    bTempIsV2Frame = false;
+    bTempIsRecovered = false;
+    TempSequence = 0;
+    TempChecksum = 0;
+    TempHexDigits = 0;
+    RunningCrc = 0;
+}
+
+bool FHenetSerialPortReader::AcceptSequence(uint8 Sequence)
+{
+    const auto IsMissing = [this](uint8 Seq) { return (MissingSequences[Seq >> 5] & (1u << (Seq & 31))) != 0; };
+    const auto SetMissing = [this](uint8 Seq, bool bMissing)
+    {
+        if (bMissing) MissingSequences[Seq >> 5] |= (1u << (Seq & 31));
+        else MissingSequences[Seq >> 5] &= ~(1u << (Seq & 31));
+    };
+
+    if (!bHaveSequence)
+    {
+        // First v2 frame on this link: nothing to compare against yet.
+        ResyncSequence(Sequence);
+        return true;
+    }
+
+    // Distance ahead of what we expected, modulo 256. Anything in the upper half is
+    // treated as "behind", i.e. a retransmission or a duplicate.
+    const uint8 Ahead = static_cast<uint8>(Sequence - ExpectedSequence);
+
+    if (Ahead < 128)
+    {
+        BehindRunLength = 0;
+    }
+
+    if (Ahead == 0)
+    {
+        SetMissing(Sequence, false);
+        ExpectedSequence = static_cast<uint8>(Sequence + 1);
+        return true;
+    }
+
+    if (Ahead >= ResyncGapFrames && Ahead < 128)
+    {
+        // Not a real gap: requesting these frames would ask for ones that never existed.
+        UE_LOG(LogHenetSwitchControl, Warning, TEXT("Sequence jumped from %u to %u; assuming the device restarted its numbering."), ExpectedSequence, Sequence);
+        ResyncSequence(Sequence);
+        return true;
+    }
+
+    if (Ahead < 128)
+    {
+        // Frames ExpectedSequence..Sequence-1 never arrived (or arrived corrupt).
+        FramesLost += Ahead;
+        UE_LOG(LogHenetSwitchControl, Warning, TEXT("Sequence gap: expected %u, got %u (%u frame(s) lost)."), ExpectedSequence, Sequence, Ahead);
+        Trace.Record(EHenetTraceKind::SequenceGap, CurrentReadCycles, ExpectedSequence, Sequence);
+
+        // A replay has no device to ask; the gap was already there when the capture was made.
+        int32 RequestsSent = 0;
+        for (uint8 Missing = ExpectedSequence; Missing != Sequence; ++Missing)
+        {
+            SetMissing(Missing, true);
+            if (GHenetRequestRetransmit && !bIsReplay && RequestsSent < MaxRetransmitRequestsPerGap)
+            {
+                const uint8 Request[] = { EProtocolChars::Proto_N, HexDigitChar(Missing >> 4), HexDigitChar(Missing) };
+                WriteFrame(Request, UE_ARRAY_COUNT(Request));
+                ++RequestsSent;
+            }
+        }
+
+        SetMissing(Sequence, false);
+        ExpectedSequence = static_cast<uint8>(Sequence + 1);
+        return true;
+    }
+
+    if (IsMissing(Sequence))
+    {
+        // A frame we gave up on has been resent. The parser decides whether it is still worth
+        // delivering: a newer edge of the same switch may already have gone out.
+        bTempIsRecovered = true;
+        SetMissing(Sequence, false);
+        --FramesLost;
+        ++FramesRecovered;
+        UE_LOG(LogHenetSwitchControl, Log, TEXT("Recovered frame %u through retransmission."), Sequence);
+        return true;
+    }
+
+    // A device that restarted numbers its frames from 0 again, which looks like a stream of
+    // duplicates. A frame 0 from well outside the duplicate window is that restart, and so is a
+    // short run of behind frames that follow one another: stray repeats don't come in order.
+    const uint8 Behind = static_cast<uint8>(ExpectedSequence - Sequence);
+    const bool bContinuesRun = BehindRunLength > 0 && Sequence == BehindRunNext;
+    BehindRunLength = bContinuesRun ? BehindRunLength + 1 : 1;
+    BehindRunNext = static_cast<uint8>(Sequence + 1);
+
+    if ((Sequence == 0 && Behind > DuplicateWindowFrames) || BehindRunLength >= ResyncBehindRun)
+    {
+        // Frames of the run before this one were dropped as duplicates and cannot be recovered.
+        FramesLost += BehindRunLength - 1;
+        UE_LOG(LogHenetSwitchControl, Warning, TEXT("Sequence restarted at %u (expected %u); resynchronizing."), Sequence, ExpectedSequence);
+        ResyncSequence(Sequence);
+        return true;
+    }
+
+    UE_LOG(LogHenetSwitchControl, Verbose, TEXT("Dropping duplicate frame %u."), Sequence);
+    return false;
+}
+
+void FHenetSerialPortReader::ResyncSequence(uint8 Sequence)
+{
+    bHaveSequence = true;
+    ExpectedSequence = static_cast<uint8>(Sequence + 1);
+    BehindRunLength = 0;
+    FMemory::Memzero(MissingSequences, sizeof(MissingSequences));
+
+    // Edge order from before the restart says nothing about the new numbering.
+    for (int32& EdgeSequence : LastEdgeSequence)
+    {
+        EdgeSequence = -1;
+    }
+}
+
+bool FHenetSerialPortReader::AcceptEdge(int32 SwitchNumber)
+{
+    if (!bTempIsV2Frame)
+    {
+        return true;
+    }
+
+    int32& LastSequence = LastEdgeSequence[SwitchNumber - 1];
+
+    // Anything recovered is behind ExpectedSequence, so "LastSequence is newer" is a short
+    // forward distance from the recovered frame to it, modulo 256.
+    if (bTempIsRecovered && LastSequence >= 0 && static_cast<uint8>(LastSequence - TempSequence) < 128)
+    {
+        UE_LOG(LogHenetSwitchControl, Log, TEXT("Dropping stale recovered edge of switch %d (frame %u, frame %d already delivered)."), SwitchNumber, TempSequence, LastSequence);
+        return false;
+    }
+
+    LastSequence = TempSequence;
+    return true;
+}
+
+bool FHenetSerialPortReader::WriteFrame(const uint8* Body, int32 BodyLength)
+{
+#if PLATFORM_WINDOWS && HENET_WINDOWS_SERIAL
+    uint8 Frame[16];
+    check(BodyLength <= static_cast<int32>(sizeof(Frame)) - 5);
+
+    int32 Length = 0;
+    Frame[Length++] = EProtocolChars::ENQ;
+    Frame[Length++] = EProtocolChars::DLE;
+    Frame[Length++] = EProtocolChars::STX;
+    FMemory::Memcpy(Frame + Length, Body, BodyLength);
+    Length += BodyLength;
+    Frame[Length++] = EProtocolChars::DLE;
+    Frame[Length++] = EProtocolChars::ETX;
+
+    DWORD BytesWritten = 0;
+    if (!WriteFile(hSerial, Frame, Length, &BytesWritten, NULL) || BytesWritten != static_cast<DWORD>(Length))
+    {
+        UE_LOG(LogHenetSwitchControl, Warning, TEXT("WriteFile to %s failed. Error code: %d"), *PortName, GetLastError());
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FHenetSerialPortReader::DeliverEvent(const FHenetSwitchEvent& Event)
+{
+    if (Event.bIsConnectionStatus)
+    {
+        Trace.Record(EHenetTraceKind::Connection, Event.TimestampCycles, Event.bIsConnected ? 1 : 0);
+    }
+    else
+    {
+        Trace.Record(EHenetTraceKind::Event, Event.TimestampCycles, static_cast<uint8>(Event.SwitchNumber), Event.bIsPressed ? 1 : 0);
+    }
+
+    // External processes see the state change before anything in this process does.
+    SharedState.PublishEvent(Event);
+
+    // Latency-critical native consumers get the event right here, before the queue.
+    WorkerCallbacks.Invoke(Event);
+
+    // Nobody is listening for this kind of event (or this switch): stop here instead of
+    // paying for a queue node and a game-thread dispatch.
+    if (Event.MatchesInterest(InterestMask.Load(EMemoryOrder::Relaxed)))
+    {
+        EventQueue.Enqueue(Event);
+    }
+}
+
 void FHenetSerialPortReader::ParseByte(uint8 Byte)
 {
-    // <-- Log level changed to VeryVerbose -->
-    UE_LOG(LogHenetSwitchControl, VeryVerbose, TEXT("ParseByte: 0x%02X, State: %d"), Byte, static_cast<int32>(ParserState));
+    const EParserState PreviousState = ParserState;
 
     // --- REFACTORED STATE MACHINE ---
     // ENQ (0x05) is treated as a "reset" signal at any point.
@@ -257,14 +768,20 @@ void FHenetSerialPortReader::ParseByte(uint8 Byte)
     // Check for ENQ first, as it can reset the state at any time.
     if (Byte == EProtocolChars::ENQ)
     {
-        UE_LOG(LogHenetSwitchControl, Verbose, TEXT("Sender is sending data (ENQ received)."));
         ParserState = EParserState::Find_DLE1;
+        Trace.Record(EHenetTraceKind::Transition, CurrentReadCycles, static_cast<uint8>(PreviousState), static_cast<uint8>(ParserState), Byte);
         // Reset message data on ENQ
-        TempSwitchNum = 0;
-        TempEventType = 0;
+        ResetFrame();
         return; // Byte processed, move to next
     }
 
+    // Every byte from the message type to the end of the body is covered by the v2 checksum.
+    // It is cheap enough to always run, and v1 frames simply never look at it.
+    if (ParserState >= EParserState::Find_Type && ParserState < EParserState::Find_Checksum)
+    {
+        RunningCrc = Crc8Update(RunningCrc, Byte);
+    }
+
     // Process byte based on current state
     switch (ParserState)
     {
@@ -281,6 +798,7 @@ void FHenetSerialPortReader::ParseByte(uint8 Byte)
         else
         {
             UE_LOG(LogHenetSwitchControl, Warning, TEXT("Parse Error: No DLE was received as expected. Resetting."));
+            NoteParseError(Byte);
             ParserState = EParserState::Find_ENQ;
         }
         break;
@@ -288,33 +806,69 @@ void FHenetSerialPortReader::ParseByte(uint8 Byte)
     case EParserState::Find_STX:
         if (Byte == EProtocolChars::STX)
         {
-            UE_LOG(LogHenetSwitchControl, Verbose, TEXT("Transmission started (STX received)."));
             ParserState = EParserState::Find_Type;
         }
         else
         {
             UE_LOG(LogHenetSwitchControl, Warning, TEXT("Parse Error: No STX was received as expected. Resetting."));
+            NoteParseError(Byte);
             ParserState = EParserState::Find_ENQ;
         }
         break;
 
     case EParserState::Find_Type:
-        if (Byte == EProtocolChars::Proto_H) // Heartbeat
+        TempMessageType = Byte;
+        if (Byte == EProtocolChars::Proto_V && !bTempIsV2Frame) // v2 prefix, followed by the sequence number
+        {
+            bTempIsV2Frame = true;
+            TempHexDigits = 0;
+            ParserState = EParserState::Find_Sequence;
+        }
+        else if (Byte == EProtocolChars::Proto_H) // Heartbeat
         {
             TempSwitchNum = 0; // Ensure TempSwitchNum is 0 for heartbeat
-            ParserState = EParserState::Find_DLE2;
+            ParserState = StateAfterBody();
         }
         else if (Byte == EProtocolChars::Proto_S) // Switch Event
         {
             ParserState = EParserState::Find_SwitchNum;
         }
+        else if (Byte == EProtocolChars::Proto_A) // Analog Sample
+        {
+            ParserState = EParserState::Find_AnalogChannel;
+        }
         else
         {
             UE_LOG(LogHenetSwitchControl, Warning, TEXT("Parse Error: Invalid message type (0x%02X). Resetting."), Byte);
+            NoteParseError(Byte);
             ParserState = EParserState::Find_ENQ;
         }
         break;
 
+    case EParserState::Find_Sequence:
+    case EParserState::Find_Checksum:
+    {
+        // Both are two ASCII hex digits, most significant first.
+        const int32 Digit = HexDigitValue(Byte);
+        if (Digit < 0)
+        {
+            UE_LOG(LogHenetSwitchControl, Warning, TEXT("Parse Error: Invalid %s digit (0x%02X). Resetting."),
+                ParserState == EParserState::Find_Sequence ? TEXT("sequence") : TEXT("checksum"), Byte);
+            NoteParseError(Byte);
+            ParserState = EParserState::Find_ENQ;
+            break;
+        }
+
+        uint8& Target = (ParserState == EParserState::Find_Sequence) ? TempSequence : TempChecksum;
+        Target = static_cast<uint8>((Target << 4) | Digit);
+        if (++TempHexDigits == 2)
+        {
+            TempHexDigits = 0;
+            ParserState = (ParserState == EParserState::Find_Sequence) ? EParserState::Find_Type : EParserState::Find_DLE2;
+        }
+        break;
+    }
+
     case EParserState::Find_SwitchNum:
         if (Byte >= '1' && Byte <= '4')
         {
@@ -324,6 +878,7 @@ void FHenetSerialPortReader::ParseByte(uint8 Byte)
         else
         {
             UE_LOG(LogHenetSwitchControl, Warning, TEXT("Parse Error: Invalid switch number (0x%02X). Resetting."), Byte);
+            NoteParseError(Byte);
             ParserState = EParserState::Find_ENQ;
         }
         break;
@@ -332,15 +887,54 @@ void FHenetSerialPortReader::ParseByte(uint8 Byte)
         if (Byte == EProtocolChars::Proto_P || Byte == EProtocolChars::Proto_R)
         {
             TempEventType = Byte;
-            ParserState = EParserState::Find_DLE2;
+            ParserState = StateAfterBody();
         }
         else
         {
             UE_LOG(LogHenetSwitchControl, Warning, TEXT("Parse Error: Invalid event type (0x%02X). Resetting."), Byte);
+            NoteParseError(Byte);
+            ParserState = EParserState::Find_ENQ;
+        }
+        break;
+
+    case EParserState::Find_AnalogChannel:
+        if (Byte >= '1' && Byte < '1' + NumAnalogChannels)
+        {
+            TempAnalogChannel = Byte - '0'; // Convert '1' -> 1
+            TempAnalogValue = 0;
+            TempAnalogDigits = 0;
+            ParserState = EParserState::Find_AnalogValue;
+        }
+        else
+        {
+            UE_LOG(LogHenetSwitchControl, Warning, TEXT("Parse Error: Invalid analog channel (0x%02X). Resetting."), Byte);
+            NoteParseError(Byte);
             ParserState = EParserState::Find_ENQ;
         }
         break;
 
+    case EParserState::Find_AnalogValue:
+    {
+        // The sample is sent as four ASCII hex digits, most significant first, so that
+        // no payload byte can ever be mistaken for ENQ or DLE.
+        const int32 Digit = HexDigitValue(Byte);
+        if (Digit >= 0)
+        {
+            TempAnalogValue = static_cast<uint16>((TempAnalogValue << 4) | Digit);
+            if (++TempAnalogDigits == 4)
+            {
+                ParserState = StateAfterBody();
+            }
+        }
+        else
+        {
+            UE_LOG(LogHenetSwitchControl, Warning, TEXT("Parse Error: Invalid analog value digit (0x%02X). Resetting."), Byte);
+            NoteParseError(Byte);
+            ParserState = EParserState::Find_ENQ;
+        }
+        break;
+    }
+
     case EParserState::Find_DLE2:
         if (Byte == EProtocolChars::DLE)
         {
@@ -349,39 +943,68 @@ void FHenetSerialPortReader::ParseByte(uint8 Byte)
         else
         {
             UE_LOG(LogHenetSwitchControl, Warning, TEXT("Parse Error: No DLE (2) was received as expected. Resetting."));
+            NoteParseError(Byte);
             ParserState = EParserState::Find_ENQ;
         }
         break;
 
     case EParserState::Find_ETX:
-        if (Byte == EProtocolChars::ETX)
+        if (Byte != EProtocolChars::ETX)
+        {
+            UE_LOG(LogHenetSwitchControl, Warning, TEXT("Parse Error: ETX was expected but not received (0x%02X). Resetting."), Byte);
+            NoteParseError(Byte);
+        }
+        else if (bTempIsV2Frame && TempChecksum != RunningCrc)
         {
-            UE_LOG(LogHenetSwitchControl, Verbose, TEXT("End of data was received (ETX)."));
+            // The sequence number of a corrupt frame can't be trusted either; the gap will
+            // show up (and be requested again) when the next good frame arrives.
+            UE_LOG(LogHenetSwitchControl, Warning, TEXT("Checksum mismatch on v2 frame (got 0x%02X, computed 0x%02X). Dropping."), TempChecksum, RunningCrc);
+            Trace.Record(EHenetTraceKind::ChecksumError, CurrentReadCycles, TempChecksum, RunningCrc);
+            ++FramesCorrupt;
+        }
+        else if (!bTempIsV2Frame || AcceptSequence(TempSequence))
+        {
+            ++FramesReceived;
+
+            if (bTempIsV2Frame && !bLinkIsV2.load(std::memory_order_relaxed))
+            {
+                UE_LOG(LogHenetSwitchControl, Log, TEXT("Device on %s is using protocol v2 (sequence numbers and CRC)."), *PortName);
+                bLinkIsV2.store(true);
+            }
             
             // --- Valid Message Received ---
-            if (TempSwitchNum == 0) // This means it was a heartbeat
+            if (TempMessageType == EProtocolChars::Proto_A)
             {
-                UE_LOG(LogHenetSwitchControl, Verbose, TEXT("Heartbeat Message Parsed."));
-                EventQueue.Enqueue(FHenetSwitchEvent(true));
+                // Analog samples bypass the event queue entirely; they are filtered,
+                // decimated and stored in the channel's ring for the game thread to batch-read.
+                AnalogChannels[TempAnalogChannel - 1].PushSample(TempAnalogValue);
+            }
+            else if (TempSwitchNum == 0) // This means it was a heartbeat
+            {
+                // A heartbeat that arrives late through a retransmission says nothing new.
+                if (!bTempIsRecovered)
+                {
+                    FHenetSwitchEvent Event(true);
+                    Event.TimestampCycles = CurrentByteCycles;
+                    DeliverEvent(Event);
+                }
             }
             else
             {
                 int32 SwitchNum = TempSwitchNum - '0'; // Convert '1' -> 1
                 bool bPressed = (TempEventType == EProtocolChars::Proto_P);
-                UE_LOG(LogHenetSwitchControl, Verbose, TEXT("Switch Message Parsed: Switch %d, %s"), 
-                    SwitchNum, bPressed ? TEXT("Pressed") : TEXT("Released"));
-                EventQueue.Enqueue(FHenetSwitchEvent(SwitchNum, bPressed));
+                if (AcceptEdge(SwitchNum))
+                {
+                    FHenetSwitchEvent Event(SwitchNum, bPressed);
+                    Event.TimestampCycles = CurrentByteCycles;
+                    DeliverEvent(Event);
+                }
             }
         }
-        else
-        {
-            UE_LOG(LogHenetSwitchControl, Warning, TEXT("Parse Error: ETX was expected but not received (0x%02X). Resetting."), Byte);
-        }
         
         // Always reset after processing or error at this stage
         ParserState = EParserState::Find_ENQ;
-        TempSwitchNum = 0;
-        TempEventType = 0;
+        ResetFrame();
         break;
 
     default:
@@ -389,4 +1012,57 @@ void FHenetSerialPortReader::ParseByte(uint8 Byte)
         ParserState = EParserState::Find_ENQ;
         break;
     }
+
+    // One fixed-size record per state change; it costs a few stores and is only
+    // formatted if somebody asks for the trace.
+    if (ParserState != PreviousState)
+    {
+        Trace.Record(EHenetTraceKind::Transition, CurrentReadCycles, static_cast<uint8>(PreviousState), static_cast<uint8>(ParserState), Byte);
+    }
+}
+
+void FHenetSerialPortReader::NoteParseError(uint8 Byte)
+{
+    ++ParseErrors;
+    Trace.Record(EHenetTraceKind::ParseError, CurrentReadCycles, static_cast<uint8>(ParserState), 0, Byte);
+}
+
+/** Parser state names for trace output, in EParserState order. */
+static const TCHAR* GetParserStateName(uint8 State)
+{
+    static const TCHAR* const Names[] =
+    {
+        TEXT("Find_ENQ"), TEXT("Find_DLE1"), TEXT("Find_STX"), TEXT("Find_Type"), TEXT("Find_Sequence"),
+        TEXT("Find_SwitchNum"), TEXT("Find_EventType"), TEXT("Find_AnalogChannel"), TEXT("Find_AnalogValue"),
+        TEXT("Find_Checksum"), TEXT("Find_DLE2"), TEXT("Find_ETX")
+    };
+    return State < UE_ARRAY_COUNT(Names) ? Names[State] : TEXT("Unknown");
+}
+
+FString FHenetSerialPortReader::FormatTraceRecord(const FHenetTraceRecord& Record, uint64 BaseCycles)
+{
+    const double Milliseconds = FPlatformTime::ToMilliseconds64(Record.Cycles - BaseCycles);
+
+    switch (Record.Kind)
+    {
+    case EHenetTraceKind::Bytes:
+        return FString::Printf(TEXT("%10.3f ms  Bytes      %s"), Milliseconds, *FString::FromHexBlob(Record.Data, Record.Length));
+    case EHenetTraceKind::Transition:
+        return FString::Printf(TEXT("%10.3f ms  State      %s -> %s on 0x%02X"), Milliseconds,
+            GetParserStateName(Record.Arg0), GetParserStateName(Record.Arg1), Record.Arg2);
+    case EHenetTraceKind::ParseError:
+        return FString::Printf(TEXT("%10.3f ms  ParseError in %s on 0x%02X"), Milliseconds, GetParserStateName(Record.Arg0), Record.Arg2);
+    case EHenetTraceKind::ChecksumError:
+        return FString::Printf(TEXT("%10.3f ms  BadCRC     got 0x%02X, computed 0x%02X"), Milliseconds, Record.Arg0, Record.Arg1);
+    case EHenetTraceKind::SequenceGap:
+        return FString::Printf(TEXT("%10.3f ms  SeqGap     expected %u, got %u"), Milliseconds, Record.Arg0, Record.Arg1);
+    case EHenetTraceKind::Event:
+        return Record.Arg0 == 0
+            ? FString::Printf(TEXT("%10.3f ms  Event      Heartbeat"), Milliseconds)
+            : FString::Printf(TEXT("%10.3f ms  Event      Switch %u %s"), Milliseconds, Record.Arg0, Record.Arg1 ? TEXT("Pressed") : TEXT("Released"));
+    case EHenetTraceKind::Connection:
+        return FString::Printf(TEXT("%10.3f ms  Connection %s"), Milliseconds, Record.Arg0 ? TEXT("Connected") : TEXT("Disconnected"));
+    default:
+        return FString::Printf(TEXT("%10.3f ms  Unknown record kind %u"), Milliseconds, static_cast<uint8>(Record.Kind));
+    }
 }
\ No newline at end of file
@@ -0,0 +1,176 @@
+// Copyright Henet LLC 2025
+// Implementation of the shared-memory state export.
+
+#include "HenetSharedStateExport.h"
+#include "HenetSerialPortReader.h"
+#include "HenetSwitchControlModule.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformProcess.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/WindowsHWrapper.h"
+#endif
+
+/** Seqlock read attempts before TryRead gives up, so a writer that died mid-update can't hang a reader. */
+static constexpr int32 MaxReadAttempts = 1000;
+
+FHenetSharedStateExport::~FHenetSharedStateExport()
+{
+	Close();
+}
+
+FString FHenetSharedStateExport::MakeSegmentName(const FString& PortName)
+{
+	return FString::Printf(TEXT("HenetSwitchControl_%s"), *PortName.TrimStartAndEnd().ToUpper());
+}
+
+bool FHenetSharedStateExport::Open(const FString& PortName)
+{
+	Close();
+
+	const FString SegmentName = MakeSegmentName(PortName);
+
+#if PLATFORM_WINDOWS
+	// FPlatformMemory::MapNamedSharedMemoryRegion creates the mapping in the Global\ namespace,
+	// which needs SeCreateGlobalPrivilege that a normal (non-service) process doesn't have.
+	// Local\ is per session, which is where the external readers run anyway.
+	const FString MappingName = FString(TEXT("Local\\")) + SegmentName;
+	HANDLE Mapping = ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(FHenetSharedSwitchBlock), *MappingName);
+	void* View = Mapping ? ::MapViewOfFile(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(FHenetSharedSwitchBlock)) : nullptr;
+
+	if (!View)
+	{
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("Could not create shared memory segment %s (error %u); external state export is disabled."), *MappingName, ::GetLastError());
+		if (Mapping)
+		{
+			::CloseHandle(Mapping);
+		}
+		return false;
+	}
+
+	MappingHandle = Mapping;
+	Block = static_cast<FHenetSharedSwitchBlock*>(View);
+#else
+	const uint32 AccessMode = static_cast<uint32>(FPlatformMemory::ESharedMemoryAccess::Read) | static_cast<uint32>(FPlatformMemory::ESharedMemoryAccess::Write);
+	Region = FPlatformMemory::MapNamedSharedMemoryRegion(SegmentName, true, AccessMode, sizeof(FHenetSharedSwitchBlock));
+
+	if (!Region)
+	{
+		UE_LOG(LogHenetSwitchControl, Warning, TEXT("Could not create shared memory segment %s; external state export is disabled."), *SegmentName);
+		return false;
+	}
+
+	Block = static_cast<FHenetSharedSwitchBlock*>(Region->GetAddress());
+#endif
+
+	// Start from a clean, even sequence so readers never see a half-initialized block as valid.
+	Block->Magic = 0;
+	Block->LayoutVersion = FHenetSharedSwitchBlock::ExpectedLayoutVersion;
+	Block->Sequence.store(0);
+	Block->Padding = 0;
+	FMemory::Memzero(&Block->Data, sizeof(Block->Data));
+	Block->Data.SecondsPerCycle = FPlatformTime::GetSecondsPerCycle64();
+	std::atomic_thread_fence(std::memory_order_release);
+	Block->Magic = FHenetSharedSwitchBlock::ExpectedMagic;
+
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("Publishing switch state to shared memory segment %s."), *SegmentName);
+	return true;
+}
+
+void FHenetSharedStateExport::Close()
+{
+	if (Block)
+	{
+		// Leave a disconnected state behind for readers that still have the segment mapped.
+		PublishEvent(FHenetSwitchEvent::MakeConnectionStatus(false));
+
+#if PLATFORM_WINDOWS
+		::UnmapViewOfFile(Block);
+		::CloseHandle(MappingHandle);
+		MappingHandle = nullptr;
+#else
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+		Region = nullptr;
+#endif
+		Block = nullptr;
+	}
+}
+
+void FHenetSharedStateExport::PublishEvent(const FHenetSwitchEvent& Event)
+{
+	if (!Block)
+	{
+		return;
+	}
+
+	FHenetSharedSwitchData& Data = Block->Data;
+	const uint64 Cycles = Event.TimestampCycles;
+
+	// Odd sequence: write in progress. Only this thread writes, so a relaxed load is enough.
+	const uint32 Sequence = Block->Sequence.load(std::memory_order_relaxed);
+	Block->Sequence.store(Sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	if (Event.bIsConnectionStatus)
+	{
+		Data.bConnected = Event.bIsConnected ? 1 : 0;
+		if (!Event.bIsConnected)
+		{
+			// Whatever was held down is unknown once the device is gone.
+			Data.PressedMask = 0;
+		}
+	}
+	else if (Event.bIsHeartbeat)
+	{
+		++Data.HeartbeatCount;
+		Data.LastHeartbeatCycles = Cycles;
+	}
+	else if (Event.SwitchNumber >= 1 && Event.SwitchNumber <= 4)
+	{
+		const int32 Index = Event.SwitchNumber - 1;
+		if (Event.bIsPressed)
+		{
+			Data.PressedMask |= (1u << Index);
+			++Data.PressCount[Index];
+		}
+		else
+		{
+			Data.PressedMask &= ~(1u << Index);
+			++Data.ReleaseCount[Index];
+		}
+		Data.LastEdgeCycles[Index] = Cycles;
+	}
+	Data.LastUpdateCycles = Cycles;
+
+	// Even again: the block is consistent.
+	Block->Sequence.store(Sequence + 2, std::memory_order_release);
+}
+
+bool FHenetSharedStateExport::TryRead(const FHenetSharedSwitchBlock& InBlock, FHenetSharedSwitchData& OutData)
+{
+	if (InBlock.Magic != FHenetSharedSwitchBlock::ExpectedMagic || InBlock.LayoutVersion != FHenetSharedSwitchBlock::ExpectedLayoutVersion)
+	{
+		return false;
+	}
+
+	for (int32 Attempt = 0; Attempt < MaxReadAttempts; ++Attempt)
+	{
+		const uint32 Before = InBlock.Sequence.load(std::memory_order_acquire);
+		if (Before & 1)
+		{
+			FPlatformProcess::YieldThread();
+			continue;
+		}
+
+		FMemory::Memcpy(&OutData, &InBlock.Data, sizeof(OutData));
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (InBlock.Sequence.load(std::memory_order_relaxed) == Before)
+		{
+			return true;
+		}
+	}
+
+	// The sequence stayed odd or kept changing: the writer died mid-update or is stuck.
+	return false;
+}
@@ -0,0 +1,40 @@
+// Copyright Henet LLC 2025
+// Implementation of the batched event listener node.
+
+#include "HenetSwitchBatchMonitorNode.h"
+#include "HenetSwitchControlModule.h"
+
+UHenetSwitchBatchMonitorNode* UHenetSwitchBatchMonitorNode::ListenForHenetSwitchEventBatches(UObject* InWorldContextObject, UHenetSerialConnection* Connection, const TArray<int32>& Switches, bool bHeartbeat)
+{
+	UHenetSwitchBatchMonitorNode* Node = NewObject<UHenetSwitchBatchMonitorNode>();
+	Node->InitListener(InWorldContextObject, Connection, Switches, bHeartbeat);
+	return Node;
+}
+
+void UHenetSwitchBatchMonitorNode::OnStartedListening(bool bAlreadyConnected)
+{
+	if (bAlreadyConnected)
+	{
+		BatchBuffer.Reset();
+		BatchBuffer.Emplace(FHenetSwitchEvent::MakeConnectionStatus(true));
+		OnEventBatch.Broadcast(BatchBuffer);
+	}
+}
+
+void UHenetSwitchBatchMonitorNode::DispatchEvents(TConstArrayView<FHenetSwitchEvent> Events)
+{
+	BatchBuffer.Reset();
+	for (const FHenetSwitchEvent& Event : Events)
+	{
+		// Other listeners on the connection may have asked for events we didn't.
+		if (Event.MatchesInterest(InterestMask))
+		{
+			BatchBuffer.Emplace(Event);
+		}
+	}
+
+	if (BatchBuffer.Num() > 0)
+	{
+		OnEventBatch.Broadcast(BatchBuffer);
+	}
+}
@@ -4,23 +4,67 @@
 
 #include "HenetSwitchControlLibrary.h"
 #include "HenetSerialConnection.h"
+#include "HenetConnectionRegistry.h"
+#include "HenetSwitchControlModule.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Misc/App.h"
 
 UHenetSerialConnection* UHenetSwitchControlLibrary::OpenHenetSerialConnection(const FString& PortName)
 {
-	// Create a new UObject to hold the connection
-	UHenetSerialConnection* ConnectionObject = NewObject<UHenetSerialConnection>();
-	
-	// Start the connection process (this spawns the thread)
-	ConnectionObject->Open(PortName);
+	// The registry returns the connection already running on this port, or opens a new one
+	// (which spawns the thread). Either way the caller now holds one reference to it.
+	UHenetSerialConnection* ConnectionObject = FHenetSwitchControlModule::Get().GetConnectionRegistry().Acquire(PortName);
 	
 	// Return the object to Blueprints
 	return ConnectionObject;
 }
 
+UHenetSerialConnection* UHenetSwitchControlLibrary::OpenHenetReplayConnection(const FString& CapturePath, EHenetReplaySpeed Speed, float AccelerationFactor)
+{
+	double PlaybackRate = 1.0;
+	switch (Speed)
+	{
+	case EHenetReplaySpeed::Accelerated: PlaybackRate = FMath::Max(AccelerationFactor, UE_SMALL_NUMBER); break;
+	case EHenetReplaySpeed::Max: PlaybackRate = 0.0; break;
+	default: break;
+	}
+
+	// Replays are never shared, so they bypass the registry; Release closes them straight away.
+	UHenetSerialConnection* ConnectionObject = NewObject<UHenetSerialConnection>();
+	ConnectionObject->OpenReplay(FHenetCaptureWriter::ResolvePath(CapturePath, FString()), PlaybackRate);
+	return ConnectionObject;
+}
+
+UHenetSerialConnection* UHenetSwitchControlLibrary::OpenHenetAggregateConnection(const TArray<FHenetAggregateDevice>& Devices, float ReorderWindowMs)
+{
+	// The aggregate itself is not shared; the devices underneath it are, through the registry.
+	UHenetSerialConnection* ConnectionObject = NewObject<UHenetSerialConnection>();
+	ConnectionObject->OpenAggregate(Devices, ReorderWindowMs / 1000.0);
+	return ConnectionObject;
+}
+
+double UHenetSwitchControlLibrary::ConvertHenetTimestampToGameTime(const UObject* WorldContextObject, double TimestampSeconds)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull) : nullptr;
+	if (!World)
+	{
+		return 0.0;
+	}
+
+	// World->TimeSeconds was advanced for the frame that started at FApp::GetCurrentTime();
+	// both are read together, so the pair anchors the platform clock to game time.
+	const AWorldSettings* WorldSettings = World->GetWorldSettings();
+	const double Dilation = WorldSettings ? WorldSettings->GetEffectiveTimeDilation() : 1.0;
+	return World->GetTimeSeconds() + (TimestampSeconds - FApp::GetCurrentTime()) * Dilation;
+}
+
 void UHenetSwitchControlLibrary::CloseHenetSerialConnection(UHenetSerialConnection* Connection)
 {
 	if (IsValid(Connection))
 	{
-		Connection->Close();
+		// Drops this caller's reference; the port closes once nobody else is using it.
+		FHenetSwitchControlModule::Get().GetConnectionRegistry().Release(Connection);
 	}
 }
\ No newline at end of file
@@ -2,13 +2,99 @@
 // Private implementation for the HenetSwitchControl module
 
 #include "HenetSwitchControlModule.h"
+#include "HenetConnectionRegistry.h"
+#include "HenetSerialConnection.h"
+#include "HenetSwitchDispatchSubsystem.h"
+#include "HenetSwitchControlSettings.h"
+#include "Engine/Engine.h"
+#include "Misc/CoreDelegates.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
 
 // Define the custom log category
 DEFINE_LOG_CATEGORY(LogHenetSwitchControl);
 
+static float GHenetTraceFlushInterval = 0.0f;
+static FAutoConsoleVariableRef CVarHenetTraceFlushInterval(
+    TEXT("henet.TraceFlushInterval"),
+    GHenetTraceFlushInterval,
+    TEXT("If > 0, every N seconds new reader trace records of all open connections are formatted to the log. 0 (default) keeps the trace in memory only."),
+    ECVF_Default);
+
+/**
+ * Visits every open connection. The dispatch subsystem also sees replay and aggregate connections,
+ * which are not in the registry; before the engine is up only registry connections can exist.
+ */
+static void ForEachOpenConnection(TFunctionRef<void(UHenetSerialConnection&)> Visitor)
+{
+    if (const UHenetSwitchDispatchSubsystem* Dispatcher = UHenetSwitchDispatchSubsystem::Get())
+    {
+        Dispatcher->ForEachConnection(Visitor);
+    }
+    else
+    {
+        FHenetSwitchControlModule::Get().GetConnectionRegistry().ForEachConnection(Visitor);
+    }
+}
+
+static FAutoConsoleCommand CmdHenetDumpTrace(
+    TEXT("henet.DumpTrace"),
+    TEXT("Prints the recent reader trace (raw bytes, parser transitions, errors) of every open connection. Usage: henet.DumpTrace [MaxRecords]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        const int32 MaxRecords = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 200;
+        ForEachOpenConnection([MaxRecords](UHenetSerialConnection& Connection)
+        {
+            Connection.LogTrace(MaxRecords, false);
+        });
+    }));
+
+static FAutoConsoleCommand CmdHenetStartCapture(
+    TEXT("henet.StartCapture"),
+    TEXT("Records the raw byte stream of open connections to .hcap files under Saved/HenetCaptures. Usage: henet.StartCapture [Port]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        ForEachOpenConnection([&Args](UHenetSerialConnection& Connection)
+        {
+            if (Args.Num() == 0 || Connection.GetPortName().Equals(Args[0], ESearchCase::IgnoreCase))
+            {
+                FString FilePath;
+                Connection.StartCapture(FString(), FilePath);
+            }
+        });
+    }));
+
+static FAutoConsoleCommand CmdHenetStopCapture(
+    TEXT("henet.StopCapture"),
+    TEXT("Stops captures started with henet.StartCapture. Usage: henet.StopCapture [Port]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        ForEachOpenConnection([&Args](UHenetSerialConnection& Connection)
+        {
+            if (Args.Num() == 0 || Connection.GetPortName().Equals(Args[0], ESearchCase::IgnoreCase))
+            {
+                Connection.StopCapture();
+            }
+        });
+    }));
+
 void FHenetSwitchControlModule::StartupModule()
 {
     // This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file
+    ConnectionRegistry = MakeUnique<FHenetConnectionRegistry>();
+    TraceFlushTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateRaw(this, &FHenetSwitchControlModule::TickTraceFlush), 0.0f);
+
+    // Warm ports need the settings and (ideally) the engine; when loaded during engine
+    // startup, wait for it to finish so the dispatch subsystem exists.
+    if (GEngine && GEngine->IsInitialized())
+    {
+        OpenWarmConnections();
+    }
+    else
+    {
+        PostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddRaw(this, &FHenetSwitchControlModule::OpenWarmConnections);
+    }
     UE_LOG(LogHenetSwitchControl, Log, TEXT("HenetSwitchControl module has started."));
 }
 
@@ -16,7 +102,83 @@ void FHenetSwitchControlModule::ShutdownModule()
 {
     // This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
     // we call this function before unloading the module.
+    FTSTicker::GetCoreTicker().RemoveTicker(TraceFlushTickerHandle);
+    TraceFlushTickerHandle.Reset();
+    FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
+    PostEngineInitHandle.Reset();
+
+    if (ConnectionRegistry)
+    {
+        for (const TWeakObjectPtr<UHenetSerialConnection>& Connection : WarmConnections)
+        {
+            ConnectionRegistry->Release(Connection.Get());
+        }
+        WarmConnections.Empty();
+
+        ConnectionRegistry->Shutdown();
+        ConnectionRegistry.Reset();
+    }
     UE_LOG(LogHenetSwitchControl, Log, TEXT("HenetSwitchControl module has shut down."));
 }
 
-IMPLEMENT_MODULE(FHenetSwitchControlModule, HenetSwitchControl)
\ No newline at end of file
+void FHenetSwitchControlModule::OpenWarmConnections()
+{
+    FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
+    PostEngineInitHandle.Reset();
+
+    const UHenetSwitchControlSettings* Settings = GetDefault<UHenetSwitchControlSettings>();
+    if (!ConnectionRegistry || Settings->WarmPorts.Num() == 0)
+    {
+        return;
+    }
+
+    if (GIsEditor && !Settings->bWarmPortsInEditor)
+    {
+        UE_LOG(LogHenetSwitchControl, Log, TEXT("Skipping %d warm port(s) in the editor (bWarmPortsInEditor is off)."), Settings->WarmPorts.Num());
+        return;
+    }
+
+    for (const FString& ConfiguredPort : Settings->WarmPorts)
+    {
+        // Hand-edited ini values often carry stray spaces; use the same name a Blueprint would pass.
+        const FString Port = ConfiguredPort.TrimStartAndEnd();
+        if (Port.IsEmpty())
+        {
+            continue;
+        }
+
+        // The reader thread opens and configures the device, so this does not block startup.
+        UHenetSerialConnection* Connection = ConnectionRegistry->Acquire(Port);
+        if (Settings->bPreRoll)
+        {
+            Connection->EnablePreRoll(Settings->PreRollMaxEvents, Settings->PreRollMaxAgeSeconds);
+        }
+        WarmConnections.Add(Connection);
+        UE_LOG(LogHenetSwitchControl, Log, TEXT("Opening warm connection to %s."), *Port);
+    }
+}
+
+bool FHenetSwitchControlModule::TickTraceFlush(float DeltaTime)
+{
+    if (GHenetTraceFlushInterval <= 0.0f || !ConnectionRegistry)
+    {
+        return true;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    if (Now < NextTraceFlushTime)
+    {
+        return true;
+    }
+    NextTraceFlushTime = Now + GHenetTraceFlushInterval;
+
+    // Only the copy out of the ring happens here; formatting up to a full ring of records is
+    // left to a background task so a busy link doesn't cost the game thread a frame.
+    ForEachOpenConnection([](UHenetSerialConnection& Connection)
+    {
+        Connection.LogTrace(0, true, true);
+    });
+    return true;
+}
+
+IMPLEMENT_MODULE(FHenetSwitchControlModule, HenetSwitchControl)
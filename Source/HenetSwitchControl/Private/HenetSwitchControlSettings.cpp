@@ -0,0 +1,10 @@
+// Copyright Henet LLC 2025
+// Implementation of the plugin's project settings.
+
+#include "HenetSwitchControlSettings.h"
+
+UHenetSwitchControlSettings::UHenetSwitchControlSettings()
+{
+	CategoryName = TEXT("Plugins");
+	SectionName = TEXT("Henet Switch Control");
+}
@@ -0,0 +1,85 @@
+// Copyright Henet LLC 2025
+// Implementation of the per-frame dispatch subsystem.
+
+#include "HenetSwitchDispatchSubsystem.h"
+#include "HenetSerialConnection.h"
+#include "HenetSwitchControlModule.h"
+#include "Engine/Engine.h"
+#include "Misc/CoreDelegates.h"
+#include "UObject/UObjectIterator.h"
+
+UHenetSwitchDispatchSubsystem* UHenetSwitchDispatchSubsystem::Get()
+{
+	// Connections can be closed from BeginDestroy during the exit purge, after subsystems are gone.
+	return (GEngine && !GExitPurge) ? GEngine->GetEngineSubsystem<UHenetSwitchDispatchSubsystem>() : nullptr;
+}
+
+void UHenetSwitchDispatchSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// Connections opened before the engine finished initializing could not register
+	// themselves yet; pick them up now. This only runs once, so the iterator cost is fine.
+	for (TObjectIterator<UHenetSerialConnection> It; It; ++It)
+	{
+		if (It->IsOpen())
+		{
+			AddConnection(*It);
+		}
+	}
+
+	BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddUObject(this, &UHenetSwitchDispatchSubsystem::OnBeginFrame);
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("HenetSwitchDispatchSubsystem initialized (%d connection(s) already open)."), Connections.Num());
+}
+
+void UHenetSwitchDispatchSubsystem::Deinitialize()
+{
+	FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+	BeginFrameHandle.Reset();
+	Connections.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHenetSwitchDispatchSubsystem::AddConnection(UHenetSerialConnection* Connection)
+{
+	Connections.AddUnique(Connection);
+}
+
+void UHenetSwitchDispatchSubsystem::RemoveConnection(UHenetSerialConnection* Connection)
+{
+	// Only clear the slot; OnBeginFrame compacts the array so that removing a connection
+	// mid-dispatch does not shift the others and make one of them miss this frame.
+	const int32 Index = Connections.IndexOfByKey(Connection);
+	if (Index != INDEX_NONE)
+	{
+		Connections[Index].Reset();
+	}
+}
+
+void UHenetSwitchDispatchSubsystem::ForEachConnection(TFunctionRef<void(UHenetSerialConnection&)> Visitor) const
+{
+	for (const TWeakObjectPtr<UHenetSerialConnection>& Connection : Connections)
+	{
+		if (UHenetSerialConnection* Live = Connection.Get())
+		{
+			Visitor(*Live);
+		}
+	}
+}
+
+void UHenetSwitchDispatchSubsystem::OnBeginFrame()
+{
+	// Index loop because a listener may open or close connections while we dispatch.
+	for (int32 Index = 0; Index < Connections.Num(); ++Index)
+	{
+		UHenetSerialConnection* Connection = Connections[Index].Get();
+		if (!Connection)
+		{
+			Connections.RemoveAt(Index--);
+			continue;
+		}
+
+		Connection->DispatchPendingEvents();
+	}
+}
@@ -0,0 +1,115 @@
+// Copyright Henet LLC 2025
+// Implementation of the shared monitor node lifecycle.
+
+#include "HenetSwitchListenerNodeBase.h"
+#include "Engine/World.h"
+#include "HenetSwitchControlModule.h"
+
+void UHenetSwitchListenerNodeBase::InitListener(UObject* InWorldContextObject, UHenetSerialConnection* Connection, const TArray<int32>& Switches, bool bHeartbeat)
+{
+	WorldContextObject = InWorldContextObject;
+	TargetConnection = Connection;
+
+	// Every pin of an async node is bound whether it is wired or not, so the node's inputs are
+	// the only way to know what it needs.
+	const uint32 SwitchMask = Switches.Num() > 0 ? MakeSwitchInterest(Switches) : (HenetInterest::All & ~HenetInterest::Heartbeat);
+	InterestMask = SwitchMask | (bHeartbeat ? HenetInterest::Heartbeat : HenetInterest::None);
+
+	// Nothing else references the node, so keep it alive through the game instance until SetReadyToDestroy.
+	RegisterWithGameInstance(InWorldContextObject);
+}
+
+void UHenetSwitchListenerNodeBase::Activate()
+{
+	if (!WorldContextObject || !WorldContextObject->GetWorld())
+	{
+		UE_LOG(LogHenetSwitchControl, Error, TEXT("%s: Activate() FAILED. No valid world context."), *GetClass()->GetName());
+		SetReadyToDestroy();
+		return;
+	}
+
+	if (!IsValid(TargetConnection))
+	{
+		UE_LOG(LogHenetSwitchControl, Error, TEXT("%s: Activate() FAILED. Connection object is invalid."), *GetClass()->GetName());
+		SetReadyToDestroy();
+		return;
+	}
+
+	// Events are pushed to us once per frame by UHenetSwitchDispatchSubsystem; no polling timer needed.
+	TargetConnection->AddListener(this, InterestMask);
+	bIsListening = true;
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("%s activated. Listening for events..."), *GetClass()->GetName());
+
+	OnStartedListening(TargetConnection->IsConnected());
+}
+
+void UHenetSwitchListenerNodeBase::SetReadyToDestroy()
+{
+	// Stop receiving events
+	if (TargetConnection)
+	{
+		TargetConnection->RemoveListener(this);
+	}
+	bIsListening = false;
+
+	UBlueprintAsyncActionBase::SetReadyToDestroy();
+}
+
+void UHenetSwitchListenerNodeBase::BeginDestroy()
+{
+	// The connection holds a raw listener pointer; make sure it never outlives us.
+	if (TargetConnection)
+	{
+		TargetConnection->RemoveListener(this);
+	}
+	Super::BeginDestroy();
+}
+
+void UHenetSwitchListenerNodeBase::StopListening()
+{
+	UE_LOG(LogHenetSwitchControl, Log, TEXT("StopListening called on %s. Unregistering listener..."), *GetClass()->GetName());
+	// This just stops *this* listener, it does not close the connection.
+	SetReadyToDestroy();
+}
+
+uint32 UHenetSwitchListenerNodeBase::MakeSwitchInterest(const TArray<int32>& Switches)
+{
+	uint32 Mask = HenetInterest::None;
+	for (int32 SwitchNumber : Switches)
+	{
+		if (SwitchNumber >= 1 && SwitchNumber <= HenetInterest::MaxSwitchNumber)
+		{
+			Mask |= HenetInterest::Switch(SwitchNumber);
+		}
+		else
+		{
+			UE_LOG(LogHenetSwitchControl, Warning, TEXT("Henet listener node: Ignoring invalid switch number %d."), SwitchNumber);
+		}
+	}
+	return Mask;
+}
+
+void UHenetSwitchListenerNodeBase::SetEventInterest(bool bHeartbeat, const TArray<int32>& Switches)
+{
+	InterestMask = MakeSwitchInterest(Switches) | (bHeartbeat ? HenetInterest::Heartbeat : HenetInterest::None);
+
+	if (bIsListening && IsValid(TargetConnection))
+	{
+		TargetConnection->SetListenerInterest(this, InterestMask);
+	}
+}
+
+void UHenetSwitchListenerNodeBase::HandleHenetEvents(UHenetSerialConnection* Connection, TConstArrayView<FHenetSwitchEvent> Events)
+{
+	// This function runs on the Game Thread, once per frame, from UHenetSwitchDispatchSubsystem.
+
+	// The timer used to die with the world; the listener has to notice that itself.
+	if (!IsValid(WorldContextObject))
+	{
+		UE_LOG(LogHenetSwitchControl, Log, TEXT("%s: World context is gone. Stopping listener."), *GetClass()->GetName());
+		StopListening();
+		return;
+	}
+
+	DispatchEvents(Events);
+}
@@ -3,119 +3,46 @@
 // Implementation of the Event Listener (Node 2)
 
 #include "HenetSwitchMonitorNode.h"
-#include "Engine/World.h"
-#include "TimerManager.h"
 #include "HenetSwitchControlModule.h"
 #include "HenetSerialConnection.h" // <-- NEW: Include for the connection object
 
 // <-- MODIFIED: Function signature changed -->
-UHenetSwitchMonitorNode* UHenetSwitchMonitorNode::ListenForHenetSwitchEvents(UObject* InWorldContextObject, UHenetSerialConnection* Connection)
+UHenetSwitchMonitorNode* UHenetSwitchMonitorNode::ListenForHenetSwitchEvents(UObject* InWorldContextObject, UHenetSerialConnection* Connection, const TArray<int32>& Switches, bool bHeartbeat)
 {
 	UHenetSwitchMonitorNode* Node = NewObject<UHenetSwitchMonitorNode>();
-	Node->WorldContextObject = InWorldContextObject;
-	Node->TargetConnection = Connection; // <-- Store the connection
+	Node->InitListener(InWorldContextObject, Connection, Switches, bHeartbeat);
 	return Node;
 }
 
-void UHenetSwitchMonitorNode::Activate()
+void UHenetSwitchMonitorNode::OnStartedListening(bool bAlreadyConnected)
 {
-	// --- NEW: Added Log ---
-	UE_LOG(LogHenetSwitchControl, Log, TEXT("HenetSwitchMonitorNode: Activate() called."));
-
-	if (!WorldContextObject)
-	{
-		UE_LOG(LogHenetSwitchControl, Error, TEXT("HenetSwitchMonitorNode: Activate() FAILED. WorldContextObject is null."));
-		SetReadyToDestroy();
-		return;
-	}
-
-	// <-- NEW: Check if the connection object is valid -->
-	if (!IsValid(TargetConnection))
-	{
-		UE_LOG(LogHenetSwitchControl, Error, TEXT("HenetSwitchMonitorNode: Activate() FAILED. Connection object is invalid."));
-		SetReadyToDestroy();
-		return;
-	}
-
-	UWorld* World = WorldContextObject->GetWorld();
-	if (!World)
+	// We will fire OnConnected when the connection reports it, unless it already has.
+	bIsConnected = bAlreadyConnected;
+	if (bAlreadyConnected)
 	{
-		UE_LOG(LogHenetSwitchControl, Error, TEXT("HenetSwitchMonitorNode: Activate() FAILED. Failed to get World."));
-		SetReadyToDestroy();
-		return;
+		OnConnected.Broadcast();
 	}
-
-	// Set the initial connection state to false.
-	// We will fire OnConnected if we get a connection event from the queue.
-	bIsConnected = false;
-
-	// --- REMOVED ---
-	// Worker creation is now handled by Node 1
-	// ---
-
-	// Start a timer on the game thread to poll the queue
-	// --- NEW: Added Log ---
-	UE_LOG(LogHenetSwitchControl, Log, TEXT("HenetSwitchMonitorNode: Activate() success. Starting timer..."));
-	World->GetTimerManager().SetTimer(TimerHandle, this, &UHenetSwitchMonitorNode::TimerCallback, 0.01f, true);
-
-	UE_LOG(LogHenetSwitchControl, Log, TEXT("HenetSwitchMonitorNode activated. Listening for events..."));
 }
 
-void UHenetSwitchMonitorNode::SetReadyToDestroy()
+void UHenetSwitchMonitorNode::DispatchEvents(TConstArrayView<FHenetSwitchEvent> Events)
 {
-	// --- REMOVED ---
-	// Worker cleanup is now handled by the UHenetSerialConnection object
-	// ---
-
-	// Clear the timer
-	if (WorldContextObject)
+	for (const FHenetSwitchEvent& Event : Events)
 	{
-		UWorld* World = WorldContextObject->GetWorld();
-		if (World)
+		// Other listeners on the connection may have asked for events we didn't.
+		if (!Event.MatchesInterest(InterestMask))
 		{
-			World->GetTimerManager().ClearTimer(TimerHandle);
+			continue;
 		}
-	}
-	
-	UBlueprintAsyncActionBase::SetReadyToDestroy();
-}
 
-void UHenetSwitchMonitorNode::StopListening()
-{
-	UE_LOG(LogHenetSwitchControl, Log, TEXT("StopListening called on HenetSwitchMonitorNode. Stopping timer..."));
-	// This just stops *this* listener, it does not close the connection.
-	SetReadyToDestroy();
-}
-
-void UHenetSwitchMonitorNode::TimerCallback()
-{
-	// This function runs on the Game Thread
-	// --- NEW: Added Verbose log ---
-	CheckForUpdates();
-}
-
-void UHenetSwitchMonitorNode::CheckForUpdates()
-{
-	// <-- MODIFIED: Check TargetConnection instead of Worker -->
-	if (!IsValid(TargetConnection))
-	{
-		// --- NEW: Added Warning log ---
-		UE_LOG(LogHenetSwitchControl, Warning, TEXT("CheckForUpdates: TargetConnection is NOT valid. Skipping update."));
-		return;
-	}
-
-	FHenetSwitchEvent Event;
-
-	// Dequeue all events that have accumulated
-	// <-- MODIFIED: Poll the TargetConnection's queue -->
-	// --- NEW: Added Verbose log ---
-	while (TargetConnection->EventQueue.Dequeue(Event))
-	{
-		// --- NEW: Added Log for dequeued event ---
-		UE_LOG(LogHenetSwitchControl, Verbose, TEXT("CheckForUpdates: Dequeued event (Heartbeat: %s, ConnectionStatus: %s)"),
+		UE_LOG(LogHenetSwitchControl, Verbose, TEXT("DispatchEvents: Dispatching event (Heartbeat: %s, ConnectionStatus: %s)"),
 			Event.bIsHeartbeat ? TEXT("true") : TEXT("false"),
 			Event.bIsConnectionStatus ? TEXT("true") : TEXT("false"));
 
+		CurrentEventTimestamp = Event.GetTimestampSeconds();
+		const bool bIsSwitchEvent = !Event.bIsConnectionStatus && !Event.bIsHeartbeat;
+		CurrentEventSwitchNumber = bIsSwitchEvent ? Event.SwitchNumber : 0;
+		bCurrentEventPressed = bIsSwitchEvent && Event.bIsPressed;
+
 		// --- Fire the "OnUpdate" (catch-all) Pin ---
 		// This fires for *every* event, regardless of type.
 		OnUpdate.Broadcast();
@@ -0,0 +1,54 @@
+// Copyright Henet LLC 2025
+// Implementation of the binary trace ring.
+
+#include "HenetTraceRing.h"
+
+static_assert((FHenetTraceRing::Capacity & (FHenetTraceRing::Capacity - 1)) == 0, "Capacity must be a power of two");
+
+FHenetTraceRing::FHenetTraceRing()
+	: WriteIndex(0)
+{
+	FMemory::Memzero(Records, sizeof(Records));
+}
+
+void FHenetTraceRing::RecordBytes(const uint8* Bytes, int32 Count, uint64 Cycles)
+{
+	constexpr int32 BytesPerRecord = UE_ARRAY_COUNT(FHenetTraceRecord::Data);
+
+	// Published one record at a time so that at most one slot is ever mid-write (see Read).
+	uint64 Index = WriteIndex.load(std::memory_order_relaxed);
+	for (int32 Offset = 0; Offset < Count; Offset += BytesPerRecord)
+	{
+		FHenetTraceRecord& Slot = Records[Index & (Capacity - 1)];
+		Slot.Cycles = Cycles;
+		Slot.Kind = EHenetTraceKind::Bytes;
+		Slot.Arg0 = Slot.Arg1 = Slot.Arg2 = 0;
+		Slot.Length = static_cast<uint8>(FMath::Min(BytesPerRecord, Count - Offset));
+		FMemory::Memcpy(Slot.Data, Bytes + Offset, Slot.Length);
+		WriteIndex.store(++Index, std::memory_order_release);
+	}
+}
+
+uint64 FHenetTraceRing::Read(uint64 FromIndex, TArray<FHenetTraceRecord>& Out) const
+{
+	const uint64 End = WriteIndex.load(std::memory_order_acquire);
+	uint64 Begin = FMath::Max(FromIndex, End > Capacity ? End - Capacity : 0);
+
+	const int32 FirstOut = Out.Num();
+	for (uint64 Index = Begin; Index < End; ++Index)
+	{
+		Out.Add(Records[Index & (Capacity - 1)]);
+	}
+
+	// Anything the writer lapped while we were copying may be torn; drop it. That includes the
+	// unpublished slot at EndAfterCopy, which the writer may be in the middle of.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64 EndAfterCopy = WriteIndex.load(std::memory_order_relaxed);
+	if (EndAfterCopy + 1 > Begin + Capacity)
+	{
+		const int32 Overwritten = static_cast<int32>(FMath::Min<uint64>(EndAfterCopy + 1 - Capacity - Begin, End - Begin));
+		Out.RemoveAt(FirstOut, Overwritten, EAllowShrinking::No);
+	}
+
+	return End;
+}
@@ -0,0 +1,118 @@
+// Copyright Henet LLC 2025
+// Implementation of the reader-thread callback list.
+
+#include "HenetWorkerCallbackList.h"
+#include "HenetSerialPortReader.h"
+#include "Misc/ScopeLock.h"
+
+FHenetWorkerCallbackList::FHenetWorkerCallbackList()
+	: Current(new FSnapshot())
+	, QuiescentEpoch(0)
+	, bReaderFinished(false)
+{
+}
+
+FHenetWorkerCallbackList::~FHenetWorkerCallbackList()
+{
+	// The reader thread has been joined by now, so nothing can still be looking at a snapshot.
+	for (const TPair<uint64, const FSnapshot*>& Pair : Retired)
+	{
+		delete Pair.Value;
+	}
+	delete Current.load();
+}
+
+FDelegateHandle FHenetWorkerCallbackList::Add(FHenetWorkerCallback Callback, uint32 InterestMask)
+{
+	FEntry Entry{ FDelegateHandle(FDelegateHandle::GenerateNewHandle), InterestMask,
+		MakeShared<const FHenetWorkerCallback, ESPMode::ThreadSafe>(MoveTemp(Callback)) };
+	const FDelegateHandle Handle = Entry.Handle;
+
+	FScopeLock Lock(&WriterLock);
+
+	// Entries share their callables, so copying the list only copies pointers.
+	FSnapshot* NewSnapshot = new FSnapshot(*Current.load());
+	NewSnapshot->Entries.Add(MoveTemp(Entry));
+	Publish(NewSnapshot);
+
+	return Handle;
+}
+
+bool FHenetWorkerCallbackList::Remove(FDelegateHandle Handle)
+{
+	FScopeLock Lock(&WriterLock);
+
+	const FSnapshot* OldSnapshot = Current.load();
+	if (!OldSnapshot->Entries.ContainsByPredicate([Handle](const FEntry& Entry) { return Entry.Handle == Handle; }))
+	{
+		return false;
+	}
+
+	FSnapshot* NewSnapshot = new FSnapshot(*OldSnapshot);
+	NewSnapshot->Entries.RemoveAll([Handle](const FEntry& Entry) { return Entry.Handle == Handle; });
+	Publish(NewSnapshot);
+	return true;
+}
+
+void FHenetWorkerCallbackList::CopyFrom(const FHenetWorkerCallbackList& Other)
+{
+	TArray<FEntry> OtherEntries;
+	{
+		FScopeLock OtherLock(&Other.WriterLock);
+		OtherEntries = Other.Current.load()->Entries;
+	}
+
+	FScopeLock Lock(&WriterLock);
+
+	FSnapshot* NewSnapshot = new FSnapshot(*Current.load());
+	NewSnapshot->Entries.Append(MoveTemp(OtherEntries));
+	Publish(NewSnapshot);
+}
+
+void FHenetWorkerCallbackList::Publish(const FSnapshot* NewSnapshot)
+{
+	const FSnapshot* OldSnapshot = Current.exchange(NewSnapshot);
+
+	// The reader may have loaded OldSnapshot just before the exchange. Its next Quiesce
+	// moves the epoch past the value read here, after which it can only see NewSnapshot.
+	Retired.Emplace(QuiescentEpoch.load(), OldSnapshot);
+	ReclaimRetired();
+}
+
+void FHenetWorkerCallbackList::ReaderFinished()
+{
+	bReaderFinished.store(true);
+
+	// Without this, snapshots retired after the reader's last Quiesce would wait for one that never comes.
+	FScopeLock Lock(&WriterLock);
+	ReclaimRetired();
+}
+
+void FHenetWorkerCallbackList::ReclaimRetired()
+{
+	const uint64 Epoch = QuiescentEpoch.load();
+	const bool bFreeAll = bReaderFinished.load();
+	Retired.RemoveAll([Epoch, bFreeAll](const TPair<uint64, const FSnapshot*>& Pair)
+	{
+		if (bFreeAll || Epoch > Pair.Key)
+		{
+			delete Pair.Value;
+			return true;
+		}
+		return false;
+	});
+}
+
+void FHenetWorkerCallbackList::Invoke(const FHenetSwitchEvent& Event) const
+{
+	// Sequentially consistent on purpose: it must not be reordered before the reader's
+	// previous Quiesce, or a snapshot could be loaded after it was judged unreachable.
+	const FSnapshot* Snapshot = Current.load();
+	for (const FEntry& Entry : Snapshot->Entries)
+	{
+		if (Event.MatchesInterest(Entry.InterestMask))
+		{
+			(*Entry.Callback)(Event);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+// Copyright Henet LLC 2025
+// Worker-side storage for high-rate analog sample channels (potentiometers, encoders)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Atomic.h"
+#include <atomic>
+
+/**
+ * One analog sample channel.
+ *
+ * The serial reader thread is the only producer: it filters and decimates raw samples and
+ * writes them into a fixed-size ring. The game thread is the only consumer: it either reads
+ * the latest filtered value or drains everything written since its last call, once per frame.
+ * Nothing here allocates or takes a lock, so a 1 kHz stream costs one ring write per kept sample.
+ */
+class HENETSWITCHCONTROL_API FHenetAnalogChannel
+{
+public:
+    /** Number of samples the ring can hold before the oldest are overwritten. Must be a power of two. */
+    static constexpr uint32 RingCapacity = 1024;
+
+    FHenetAnalogChannel();
+
+    /**
+     * Sets how samples are reduced before they reach the ring. Safe to call from any thread.
+     * @param InDecimation Keep one of every N samples (1 keeps all).
+     * @param InSmoothing 0 disables filtering; values towards 1 apply a stronger exponential moving average.
+     */
+    void Configure(int32 InDecimation, float InSmoothing);
+
+    /** Takes over the decimation and smoothing of another channel, e.g. when a reader is restarted. Any thread. */
+    void CopyConfiguration(const FHenetAnalogChannel& Other);
+
+    /** (Worker thread) Filters, decimates and stores one raw sample. */
+    void PushSample(uint16 RawValue);
+
+    /** (Any thread) Latest filtered value, updated for every sample regardless of decimation. */
+    float GetLatestValue() const { return LatestValue.load(std::memory_order_relaxed); }
+
+    /**
+     * (Game thread) Copies every decimated sample written since the previous call into OutSamples.
+     * If the consumer fell more than RingCapacity samples behind, the oldest ones are skipped.
+     * @return The number of samples copied.
+     */
+    int32 ConsumeSamples(TArray<float>& OutSamples);
+
+private:
+    // Configuration, written by the game thread and read by the worker.
+    // TAtomic only covers integral types, hence std::atomic for the float fields.
+    TAtomic<int32> Decimation;
+    std::atomic<float> SmoothingAlpha;
+
+    // Worker thread only
+    float FilteredValue;
+    int32 DecimationCounter;
+    bool bHasFilteredValue;
+
+    // Shared between worker (writer) and game thread (reader)
+    std::atomic<float> LatestValue;
+    TAtomic<uint32> WriteIndex;
+    float Ring[RingCapacity];
+
+    // Game thread only
+    uint32 ReadIndex;
+};
@@ -0,0 +1,132 @@
+// Copyright Henet LLC 2025
+// Raw serial stream capture files (.hcap): writer used by the reader thread and a memory-mapped reader for replay.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/UniquePtr.h"
+
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Capture file layout (little-endian, version 1):
+ *
+ *   FHenetCaptureFileHeader                       32 bytes
+ *   repeated until end of file:
+ *     uint32 DeltaMicros                          time since the previous record (or since capture start)
+ *     uint16 Length                               number of bytes that follow
+ *     uint8  Bytes[Length]                        exactly what one ReadFile returned
+ *
+ * Records are appended as they are read, so a capture cut short by a crash is still readable
+ * up to its last complete record. Each record is one read, which keeps the original chunking
+ * (and therefore the parser's exact behaviour) reproducible on replay.
+ */
+struct FHenetCaptureFileHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x50414348; // "HCAP"
+	static constexpr uint16 ExpectedVersion = 1;
+
+	uint32 Magic;
+	uint16 Version;
+	uint16 HeaderSize;
+
+	/** FDateTime::UtcNow().GetTicks() when the capture started. */
+	int64 StartUtcTicks;
+
+	/** Line speed the port was configured with, for reference. */
+	uint32 BaudRate;
+	uint32 Flags;
+	uint64 Reserved;
+};
+
+static_assert(sizeof(FHenetCaptureFileHeader) == 32, "The capture header layout is part of the file format");
+
+/** Size of the header in front of every record. */
+static constexpr int32 HenetCaptureRecordHeaderSize = 6;
+
+/** Options for a reader that replays a capture file instead of opening a serial port. */
+struct FHenetReplayOptions
+{
+	/** Capture file to replay. */
+	FString CapturePath;
+
+	/** 1 replays at the recorded pace, 2 twice as fast, and so on. 0 or less replays as fast as the parser can go. */
+	double PlaybackRate = 1.0;
+};
+
+/**
+ * Appends reads to a capture file. Buffered; the file is flushed when the buffer fills,
+ * about once a second while data is flowing, and on Close.
+ * Open may be called on any thread; Append and Close on the thread that owns the writer.
+ */
+class HENETSWITCHCONTROL_API FHenetCaptureWriter
+{
+public:
+	~FHenetCaptureWriter();
+
+	/** Creates the file (and its directory) and writes the header. */
+	bool Open(const FString& InPath, uint32 BaudRate);
+
+	/** Appends one read, stamped with FPlatformTime::Cycles64(). */
+	void Append(uint64 Cycles, const uint8* Bytes, int32 Count);
+
+	/** Flushes and closes the file. */
+	void Close();
+
+	const FString& GetPath() const { return Path; }
+
+	/**
+	 * Turns a user-supplied name into a full path. Relative names go under Saved/HenetCaptures;
+	 * an empty name becomes <Port>_<timestamp>.hcap.
+	 */
+	static FString ResolvePath(const FString& FileName, const FString& PortName);
+
+private:
+	void Flush();
+
+	TUniquePtr<IFileHandle> File;
+	FString Path;
+	TArray<uint8> Buffer;
+	uint64 LastCycles = 0;
+	uint64 LastFlushCycles = 0;
+	int64 BytesCaptured = 0;
+};
+
+/**
+ * Reads a capture file record by record. The file is memory-mapped when the platform
+ * supports it, so replay costs no copies and no allocations per record.
+ */
+class HENETSWITCHCONTROL_API FHenetCaptureReader
+{
+public:
+	FHenetCaptureReader();
+	~FHenetCaptureReader();
+
+	/** Maps (or loads) the file and validates the header. */
+	bool Open(const FString& Path);
+
+	/**
+	 * Returns the next record. OutBytes points into the mapped file and stays valid until the reader is destroyed.
+	 * @param OutMicros Time of the record since the capture started.
+	 * @return False at the end of the file or at a truncated record.
+	 */
+	bool Next(uint64& OutMicros, const uint8*& OutBytes, int32& OutCount);
+
+	/** Start of the capture, as FDateTime ticks. */
+	int64 GetStartUtcTicks() const { return StartUtcTicks; }
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	/** Used instead of the mapping on platforms that cannot map files. */
+	TArray<uint8> LoadedFile;
+
+	const uint8* Data;
+	int64 Size;
+	int64 Offset;
+	uint64 ElapsedMicros;
+	int64 StartUtcTicks;
+};
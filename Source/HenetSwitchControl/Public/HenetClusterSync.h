@@ -0,0 +1,127 @@
+// Copyright Henet LLC 2025
+// Frame-locked distribution of switch events to the other render nodes of a cluster.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SharedPointer.h"
+
+class FSocket;
+class FInternetAddr;
+struct FHenetSwitchEvent;
+
+/** What a connection does in a cluster (henet.Cluster.Role, or -HenetClusterRole= on the command line). */
+enum class EHenetClusterRole : uint8
+{
+	/** Standalone: events are applied as soon as they are dispatched. */
+	Off,
+	/** Opens the device and distributes its events to the peers. */
+	Owner,
+	/** Has no device; applies the events the owner distributes. */
+	Peer
+};
+
+/**
+ * Makes every node of a cluster apply a switch event in the same frame.
+ *
+ * The owner tags each frame's batch of events with a target frame, henet.Cluster.FrameDelay
+ * frames ahead of its own, multicasts it (UDP, loopback enabled, so several processes on one
+ * host work too) and holds the batch back locally until that frame. Every owner packet also
+ * carries the owner's current frame, from which peers estimate the offset between the owner's
+ * frame numbers and their own; a peer releases a batch when its local frame reaches the target
+ * translated by that offset. Each batch is repeated in the following packets while its target
+ * is still ahead, so a single lost datagram does not lose events.
+ *
+ * Frame numbers are GFrameCounter. This assumes the nodes run frame-locked (e.g. nDisplay), so
+ * the offset is constant; the estimate is the largest offset seen over the last packets, i.e.
+ * the one least inflated by network delay.
+ *
+ * Game thread only.
+ */
+class HENETSWITCHCONTROL_API FHenetClusterSync
+{
+public:
+	FHenetClusterSync(EHenetClusterRole InRole, const FString& InPortName);
+	~FHenetClusterSync();
+
+	/** The role configured for connections opened now. */
+	static EHenetClusterRole GetConfiguredRole();
+
+	/** Creates the multicast socket. Returns false if networking is unavailable. */
+	bool Open();
+
+	EHenetClusterRole GetRole() const { return Role; }
+
+	/**
+	 * Called once per frame from the connection's dispatch.
+	 * @param InOutEvents On input, the events drained from the local reader (owner only). On output,
+	 *                    the events due in this frame, which are what the connection dispatches.
+	 * @param bDeviceConnected (Owner) Whether the device is currently connected; forwarded to peers.
+	 */
+	void Process(TArray<FHenetSwitchEvent>& InOutEvents, bool bDeviceConnected);
+
+	/** (Peer) True while the owner reports a connected device and its packets keep arriving. */
+	bool IsOwnerConnected() const { return bOwnerConnected; }
+
+private:
+	struct FBatch
+	{
+		/** Target frame in the owner's numbering. */
+		uint64 TargetFrame = 0;
+		TArray<FHenetSwitchEvent> Events;
+	};
+
+	void ProcessOwner(TArray<FHenetSwitchEvent>& InOutEvents, bool bDeviceConnected);
+	void ProcessPeer(TArray<FHenetSwitchEvent>& OutEvents);
+
+	/** (Peer) Reads one datagram into HeldBatches. Returns false if it was not a valid packet for this port. */
+	bool ReadPacket(const uint8* Data, int32 Size);
+
+	/** (Peer) Current estimate of OwnerFrame - LocalFrame. */
+	int64 GetFrameOffset() const;
+
+	/** Moves the events of every batch targeted at or before DueOwnerFrame (owner numbering) into OutEvents, in order. */
+	static void ReleaseDue(TArray<FBatch>& Batches, int64 DueOwnerFrame, TArray<FHenetSwitchEvent>& OutEvents);
+
+	EHenetClusterRole Role;
+	FString PortName;
+
+	FSocket* Socket = nullptr;
+	TSharedPtr<FInternetAddr> GroupAddress;
+
+	/** Batches waiting for their target frame, oldest first. */
+	TArray<FBatch> HeldBatches;
+
+	/** (Owner) Batches still being repeated to peers. */
+	TArray<FBatch> RecentBatches;
+
+	/** (Owner) Events beyond the per-batch limit, carried over to the next frame's batch. */
+	TArray<FHenetSwitchEvent> OverflowEvents;
+
+	/** (Owner) Reused packet buffer. (Peer) Reused receive buffer. */
+	TArray<uint8> PacketBuffer;
+
+	/** (Owner) Random id of this run, sent in every packet. (Peer) The id of the owner run being followed. */
+	uint32 SessionId = 0;
+
+	/** (Peer) Highest target frame received, to drop repeated batches. */
+	uint64 LastReceivedTarget = 0;
+
+	/** (Peer) Recent OwnerFrame - LocalFrame samples. */
+	static constexpr int32 NumOffsetSamples = 64;
+	int64 OffsetSamples[NumOffsetSamples];
+	int32 NumSamples = 0;
+	int32 NextSample = 0;
+
+	/** (Peer) Connection state reported by the owner. */
+	bool bOwnerConnected = false;
+
+	/** (Peer) Connection state last passed on to listeners. */
+	bool bReportedConnected = false;
+
+	/** (Peer) FPlatformTime::Seconds() of the last valid packet. */
+	double LastPacketTime = 0.0;
+
+	/** (Peer) Batches released after their target frame had already passed. */
+	int32 LateBatches = 0;
+};
@@ -0,0 +1,71 @@
+// Copyright Henet LLC 2025
+// Module-level registry that shares one serial connection per port.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Templates/FunctionFwd.h"
+#include "UObject/WeakObjectPtr.h"
+
+class UHenetSerialConnection;
+
+/**
+ * Hands out shared, reference-counted connections keyed by port name.
+ *
+ * A COM port can only be opened once (exclusive share mode), so every caller that asks for
+ * the same port gets the same UHenetSerialConnection and the same reader thread.
+ * When the last reference is released the port is kept open for a short linger period
+ * (henet.ConnectionLingerSeconds) so that a level transition that closes and immediately
+ * reopens the port reuses the running reader instead of reopening the device.
+ *
+ * Game thread only.
+ */
+class HENETSWITCHCONTROL_API FHenetConnectionRegistry
+{
+public:
+	~FHenetConnectionRegistry();
+
+	/**
+	 * Returns the live connection for a port, opening it if needed, and adds a reference.
+	 * Every call must be paired with one call to Release.
+	 * @param PortName The name of the serial port (e.g., "COM3").
+	 */
+	UHenetSerialConnection* Acquire(const FString& PortName);
+
+	/**
+	 * Drops a reference added by Acquire. The port is closed once the last reference has been
+	 * released and the linger period has passed without a new Acquire.
+	 * Connections that were not created by the registry are closed immediately.
+	 */
+	void Release(UHenetSerialConnection* Connection);
+
+	/** Calls Visitor for every live connection the registry holds, referenced or lingering. */
+	void ForEachConnection(TFunctionRef<void(UHenetSerialConnection&)> Visitor) const;
+
+	/** Closes every connection regardless of outstanding references. Called on module shutdown. */
+	void Shutdown();
+
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<UHenetSerialConnection> Connection;
+		int32 RefCount = 0;
+
+		/** FPlatformTime::Seconds() after which an unreferenced entry is closed. */
+		double CloseTime = 0.0;
+	};
+
+	/** Port names are case-insensitive on Windows; normalize so "com3" and "COM3" share an entry. */
+	static FString MakeKey(const FString& PortName);
+
+	/** Core ticker callback that closes entries whose linger period has expired. */
+	bool TickLinger(float DeltaTime);
+
+	/** Closes the connection held by an entry and removes it from the root set. */
+	static void CloseEntry(FEntry& Entry);
+
+	TMap<FString, FEntry> Entries;
+
+	FTSTicker::FDelegateHandle LingerTickerHandle;
+};
@@ -8,9 +8,144 @@
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
 #include "HenetSerialPortReader.h" // For FHenetSwitchEvent
+#include "HenetClusterSync.h"
 #include "Containers/Queue.h"
+#include "Async/Future.h"
 #include "HenetSerialConnection.generated.h"
 
+class UHenetSerialConnection;
+
+/** How a wait started with UHenetSerialConnection::NextEdge finished. */
+enum class EHenetWaitResult : uint8
+{
+	/** The requested edge arrived. */
+	Triggered,
+	/** The timeout elapsed first. */
+	TimedOut,
+	/** The connection was closed while waiting. */
+	Closed
+};
+
+/** Link-quality statistics for a connection, as reported by GetLinkStats. */
+USTRUCT(BlueprintType)
+struct FHenetLinkStats
+{
+	GENERATED_BODY()
+
+	/** Frames received intact since the port was opened. */
+	UPROPERTY(BlueprintReadOnly, Category = "Henet Switch Control")
+	int32 FramesReceived = 0;
+
+	/** v2 frames dropped because their checksum did not match. */
+	UPROPERTY(BlueprintReadOnly, Category = "Henet Switch Control")
+	int32 FramesCorrupt = 0;
+
+	/** v2 frames missing from the sequence and never recovered. */
+	UPROPERTY(BlueprintReadOnly, Category = "Henet Switch Control")
+	int32 FramesLost = 0;
+
+	/** v2 frames that went missing but were recovered by a retransmission request. */
+	UPROPERTY(BlueprintReadOnly, Category = "Henet Switch Control")
+	int32 FramesRecovered = 0;
+
+	/** Framing errors (line noise, truncated frames) seen by the parser. */
+	UPROPERTY(BlueprintReadOnly, Category = "Henet Switch Control")
+	int32 ParseErrors = 0;
+
+	/** Fraction of frames lost, 0-1. Only meaningful once the device uses protocol v2. */
+	UPROPERTY(BlueprintReadOnly, Category = "Henet Switch Control")
+	float LossRate = 0.0f;
+
+	/** Fraction of frames that arrived corrupt, 0-1. Only meaningful once the device uses protocol v2. */
+	UPROPERTY(BlueprintReadOnly, Category = "Henet Switch Control")
+	float CorruptionRate = 0.0f;
+
+	/** True once the device has been detected sending v2 frames (sequence number + CRC). */
+	UPROPERTY(BlueprintReadOnly, Category = "Henet Switch Control")
+	bool bProtocolV2 = false;
+};
+
+/** What a FHenetSwitchEventData describes. */
+UENUM(BlueprintType)
+enum class EHenetSwitchEventType : uint8
+{
+	Heartbeat,
+	SwitchPressed,
+	SwitchReleased,
+	Connected,
+	Disconnected
+};
+
+/** Blueprint view of one event, as delivered by ListenForHenetSwitchEventBatches. */
+USTRUCT(BlueprintType)
+struct FHenetSwitchEventData
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Henet Switch Control")
+	EHenetSwitchEventType Type = EHenetSwitchEventType::Heartbeat;
+
+	/** Switch number for press and release events (1-4, or the mapped number on an aggregate connection), otherwise 0. */
+	UPROPERTY(BlueprintReadOnly, Category = "Henet Switch Control")
+	int32 SwitchNumber = 0;
+
+	/**
+	 * When the event arrived at the serial port, on the platform clock (FPlatformTime::Seconds).
+	 * Use ConvertHenetTimestampToGameTime to place it on the world's timeline.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Henet Switch Control")
+	double TimestampSeconds = 0.0;
+
+	FHenetSwitchEventData() = default;
+
+	explicit FHenetSwitchEventData(const FHenetSwitchEvent& Event)
+		: TimestampSeconds(Event.GetTimestampSeconds())
+	{
+		if (Event.bIsConnectionStatus)
+		{
+			Type = Event.bIsConnected ? EHenetSwitchEventType::Connected : EHenetSwitchEventType::Disconnected;
+		}
+		else if (Event.bIsHeartbeat)
+		{
+			Type = EHenetSwitchEventType::Heartbeat;
+		}
+		else
+		{
+			Type = Event.bIsPressed ? EHenetSwitchEventType::SwitchPressed : EHenetSwitchEventType::SwitchReleased;
+			SwitchNumber = Event.SwitchNumber;
+		}
+	}
+};
+
+/** One device of an aggregate connection (see OpenHenetAggregateConnection). */
+USTRUCT(BlueprintType)
+struct FHenetAggregateDevice
+{
+	GENERATED_BODY()
+
+	/** The serial port of the device (e.g., "COM3"). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Henet Switch Control")
+	FString PortName;
+
+	/** Added to the device's switch numbers: with an offset of 4, its switches 1-4 appear as 5-8. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Henet Switch Control")
+	int32 SwitchOffset = 0;
+};
+
+/**
+ * Native interface for anything that wants the events of a connection.
+ * Listeners are called on the game thread, once per frame, with every event the
+ * connection received since the previous frame (see UHenetSwitchDispatchSubsystem).
+ */
+class HENETSWITCHCONTROL_API IHenetSwitchEventListener
+{
+public:
+	virtual ~IHenetSwitchEventListener() = default;
+
+	/** Called with this frame's events, oldest first. Only called when there is at least one event. */
+	virtual void HandleHenetEvents(UHenetSerialConnection* Connection, TConstArrayView<FHenetSwitchEvent> Events) = 0;
+};
+
 /**
  * A UObject that holds a reference to an active serial port reader thread.
  * This can be passed between Blueprint nodes.
@@ -25,15 +160,206 @@ public:
 
 	/**
 	 * Opens the serial port connection by spawning the worker thread.
-	 * @param PortName The name of the serial port (e.g., "COM3").
+	 * In a cluster (henet.Cluster.Role) an owner also distributes the events to the other nodes,
+	 * and a peer opens no port at all and receives the owner's events instead.
+	 * @param InPortName The name of the serial port (e.g., "COM3").
+	 */
+	void Open(const FString& InPortName);
+
+	/**
+	 * Opens a replay of a capture file instead of a serial port. The recorded bytes go through the
+	 * same parser and the same event path as live data, so listeners cannot tell the difference.
+	 * The connection reports disconnected when the end of the capture is reached.
+	 * @param CapturePath The .hcap file to replay (see StartCapture).
+	 * @param PlaybackRate 1 for the recorded pace, N for N times faster, 0 for as fast as possible.
+	 */
+	void OpenReplay(const FString& CapturePath, double PlaybackRate = 1.0);
+
+	/**
+	 * Opens one logical connection over several devices. Each device is acquired from the
+	 * connection registry (so it can still be used on its own too) and feeds a per-device queue
+	 * straight from its reader thread. Every frame the queues are merged into a single stream
+	 * ordered by event timestamp, with switch numbers shifted by each device's offset.
+	 *
+	 * An event is held back until it is older than the reorder window, unless every device already
+	 * has a later event queued, so an event that arrives slightly late on one port is still
+	 * delivered in the right order. The connection reports connected while all devices are, and
+	 * emits one heartbeat each time every device has sent one.
+	 *
+	 * Not available with cluster sync: when a cluster role is configured, this logs an error and
+	 * leaves the connection closed.
+	 * @param ReorderWindowSeconds Longest an event waits for a possibly earlier one from another device.
 	 */
-	void Open(const FString& PortName);
+	void OpenAggregate(const TArray<FHenetAggregateDevice>& Devices, double ReorderWindowSeconds);
+
+	/** True if this connection merges several devices (see OpenAggregate). */
+	bool IsAggregate() const { return AggregateSources.Num() > 0; }
 
 	/**
 	 * Closes the serial port connection and cleans up the worker thread.
 	 */
 	void Close();
 
+	/** The port name this connection was opened with. */
+	const FString& GetPortName() const { return PortName; }
+
+	/** True if a reader thread has been started for this connection, or it is open as a cluster peer. */
+	bool IsOpen() const { return Worker != nullptr || ClusterSync.IsValid() || IsAggregate(); }
+
+	/** True if this connection replays a capture file rather than reading a device. */
+	UFUNCTION(BlueprintPure, Category = "Henet Switch Control|Capture")
+	bool IsReplay() const;
+
+	/**
+	 * Starts recording the raw byte stream of this connection to a capture file, which
+	 * OpenHenetReplayConnection can play back later. Replaces any capture in progress.
+	 * The file is created by the reader thread shortly after this returns, so the calling thread never
+	 * waits on the disk; if it cannot be created, that is logged and nothing is recorded.
+	 * @param FileName Relative names are placed under Saved/HenetCaptures; leave empty for <Port>_<timestamp>.hcap.
+	 * @param OutFilePath The full path of the file that will be written.
+	 * @return False if the connection has no running reader.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Henet Switch Control|Capture")
+	bool StartCapture(const FString& FileName, FString& OutFilePath);
+
+	/** Stops the capture started by StartCapture and closes the file. */
+	UFUNCTION(BlueprintCallable, Category = "Henet Switch Control|Capture")
+	void StopCapture();
+
+	/** True if the reader thread has ended on its own (port failed to open or the device went away). */
+	bool HasReaderStopped() const;
+
+	/**
+	 * Replaces a stopped reader thread with a new one on the same port, keeping everything else:
+	 * listeners and interest, NextEdge waits, pre-roll, analog channel configuration and worker
+	 * callbacks (whose handles stay valid). Does nothing for replays and connections without a reader.
+	 */
+	void RestartReader();
+
+	/** True while the serial port is open and being read. */
+	UFUNCTION(BlueprintPure, Category = "Henet Switch Control")
+	bool IsConnected() const;
+
+	/**
+	 * Sets how an analog channel's high-rate samples are reduced on the worker thread.
+	 * @param Channel The analog channel number (1-8).
+	 * @param Decimation Keep one of every N samples in the sample buffer (1 keeps all).
+	 * @param Smoothing 0 disables filtering. Otherwise each new sample moves the value only part of the way
+	 *                  (exponential smoothing): the value keeps this fraction of its previous reading, so
+	 *                  values towards 1 are smoother but respond more slowly. Clamped to 0.99.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Henet Switch Control|Analog")
+	void ConfigureAnalogChannel(int32 Channel, int32 Decimation = 1, float Smoothing = 0.0f);
+
+	/**
+	 * Returns the latest filtered value of an analog channel (raw device units, 0-65535).
+	 * Cheap enough to call every frame; returns 0 if the channel has not reported yet.
+	 * @param Channel The analog channel number (1-8).
+	 */
+	UFUNCTION(BlueprintPure, Category = "Henet Switch Control|Analog")
+	float GetAnalogValue(int32 Channel) const;
+
+	/**
+	 * Returns every decimated sample received on an analog channel since the previous call.
+	 * Intended to be called once per frame; OutSamples is reused so the buffer is not reallocated.
+	 * @param Channel The analog channel number (1-8).
+	 * @return The number of samples returned.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Henet Switch Control|Analog")
+	int32 ConsumeAnalogSamples(int32 Channel, TArray<float>& OutSamples);
+
+	/**
+	 * Registers a listener for this connection's events. The listener must be removed
+	 * (RemoveListener) before it is destroyed. Game thread only.
+	 * @param InterestMask The events the listener needs (HenetInterest bits). Events no consumer
+	 *                     is interested in are dropped by the reader thread right after parsing.
+	 */
+	void AddListener(IHenetSwitchEventListener* Listener, uint32 InterestMask = HenetInterest::All);
+
+	/** Changes the interest mask of a registered listener. Game thread only. */
+	void SetListenerInterest(IHenetSwitchEventListener* Listener, uint32 InterestMask);
+
+	/**
+	 * Adds to / removes from the combined interest of this connection, for consumers that are not
+	 * listeners. Every AddInterest must be matched by a RemoveInterest with the same mask.
+	 */
+	void AddInterest(uint32 InterestMask);
+	void RemoveInterest(uint32 InterestMask);
+
+	/** Unregisters a listener. Safe to call from inside HandleHenetEvents. Game thread only. */
+	void RemoveListener(IHenetSwitchEventListener* Listener);
+
+	/**
+	 * Keeps the events received while nobody is listening, instead of discarding them, and hands
+	 * them to the first listener ahead of its first batch. Pre-roll ends once delivered.
+	 * Does nothing if a listener is already attached.
+	 * @param MaxEvents Keep at most this many of the most recent events.
+	 * @param MaxAgeSeconds Drop events older than this when they are delivered.
+	 */
+	void EnablePreRoll(int32 MaxEvents, double MaxAgeSeconds);
+
+	/**
+	 * Drains the event queue and hands the batch to every listener.
+	 * Called once per frame by UHenetSwitchDispatchSubsystem; events that arrive while nobody
+	 * is listening are discarded so they cannot pile up.
+	 */
+	void DispatchPendingEvents();
+
+	/**
+	 * Returns the current link-quality statistics (loss, corruption and framing errors).
+	 * Cheap enough to poll every frame for an on-screen diagnostic.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Henet Switch Control")
+	FHenetLinkStats GetLinkStats() const;
+
+	/**
+	 * Waits for the next press or release of a switch, for native C++ gameplay code.
+	 *
+	 * The future is fulfilled on the game thread from the per-frame dispatch, so continuations
+	 * attached with Then() run there too and can touch gameplay state directly:
+	 *
+	 *     Connection->NextEdge(2, true, 5.0).Then([this](TFuture<EHenetWaitResult> Result) { ... });
+	 *
+	 * Do not block on the future (Get/Wait) from the game thread; it would never be fulfilled.
+	 * No UObject or dynamic delegate is created per wait, but each wait still makes a few small
+	 * heap allocations: the promise's shared state, plus the continuation and its TFunction when
+	 * Then() is used. That is fine for gameplay waits; don't start one per event in a hot loop.
+	 *
+	 * @param SwitchNumber The switch to watch (1-4, or a mapped number on an aggregate connection).
+	 * @param bPressed True to wait for a press, false for a release.
+	 * @param TimeoutSeconds Give up after this long. Zero or negative waits indefinitely.
+	 */
+	TFuture<EHenetWaitResult> NextEdge(int32 SwitchNumber, bool bPressed, double TimeoutSeconds = 0.0);
+
+	/**
+	 * Registers a native callback that runs directly on the serial reader thread as soon as a
+	 * frame has been parsed, bypassing the queue and the per-frame dispatch entirely.
+	 * Meant for thread-safe, latency-critical consumers (audio triggers, relays). The callback
+	 * must not block and must not touch UObjects. Registering and unregistering never stall the parser.
+	 * @param Callback Invoked on the reader thread for every event matching InterestMask.
+	 * @param InterestMask The events to receive (HenetInterest bits). Connection status is always delivered.
+	 * @return A handle for UnregisterWorkerCallback, or an invalid handle if the connection is not open.
+	 */
+	FDelegateHandle RegisterWorkerCallback(FHenetWorkerCallback Callback, uint32 InterestMask = HenetInterest::All);
+
+	/**
+	 * Unregisters a callback added with RegisterWorkerCallback. The callback may still be executing
+	 * on the reader thread when this returns. The callable itself is kept alive until the reader can
+	 * no longer reach it, so anything it needs must be owned by it: capture shared pointers by value,
+	 * not raw pointers or references to state that is freed after this call.
+	 */
+	bool UnregisterWorkerCallback(FDelegateHandle Handle);
+
+	/**
+	 * Formats the reader's binary trace (raw bytes, parser transitions, errors) to the log.
+	 * Formatting happens on the calling thread, or on a background task, never on the reader thread.
+	 * @param MaxRecords Print at most this many of the most recent records (0 = all available).
+	 * @param bOnlyNew Skip records already printed by a previous call.
+	 * @param bFormatAsync Copy the records here but format and log them on a background task.
+	 * @return The number of records printed (or handed to the background task).
+	 */
+	int32 LogTrace(int32 MaxRecords = 0, bool bOnlyNew = false, bool bFormatAsync = false);
+
 	/** Thread-safe queue for events from the worker thread */
 	TQueue<FHenetSwitchEvent, EQueueMode::Mpsc> EventQueue;
 
@@ -44,4 +370,108 @@ protected:
 private:
 	/** The worker thread object */
 	FHenetSerialPortReader* Worker = nullptr;
+
+	/** Frame-locked distribution to / from the other cluster nodes, when henet.Cluster.Role is set. */
+	TUniquePtr<FHenetClusterSync> ClusterSync;
+
+	/** Port name passed to Open */
+	FString PortName;
+
+	/** Spawns the reader thread and registers for dispatch. Shared by Open and OpenReplay. */
+	void StartWorker(const FHenetReplayOptions* ReplayOptions);
+
+	/** Roots the connection and registers it for the per-frame dispatch. */
+	void BeginDispatch();
+
+	struct FAggregateSource
+	{
+		TWeakObjectPtr<UHenetSerialConnection> Connection;
+		int32 SwitchOffset = 0;
+		FDelegateHandle CallbackHandle;
+
+		/** True once this device has sent a heartbeat since the aggregate last emitted one. */
+		bool bHeartbeatSeen = false;
+
+		/**
+		 * Filled by the device's reader thread, drained by the game thread. Shared with the callback so
+		 * a callback still running after it was unregistered never touches a freed queue.
+		 */
+		TSharedPtr<TQueue<FHenetSwitchEvent, EQueueMode::Spsc>, ESPMode::ThreadSafe> Queue;
+	};
+
+	/** Devices merged by an aggregate connection. Empty otherwise. */
+	TArray<FAggregateSource> AggregateSources;
+
+	/** See OpenAggregate. */
+	double AggregateReorderWindowSeconds = 0.0;
+
+	/** Combined connection state last reported to listeners. */
+	bool bAggregateConnected = false;
+
+	/** Appends the events that are due from the device queues, in timestamp order. */
+	void MergeAggregateSources(TArray<FHenetSwitchEvent>& OutEvents);
+
+	/** Unregisters from and releases every device of an aggregate connection. */
+	void CloseAggregateSources();
+
+	/** Pushes the combined interest of all consumers to the reader thread. */
+	void UpdateReaderInterest();
+
+	struct FListenerEntry
+	{
+		IHenetSwitchEventListener* Listener = nullptr;
+		uint32 InterestMask = HenetInterest::All;
+	};
+
+	/** Registered listeners. Entries are nulled (not removed) while a dispatch is in progress. */
+	TArray<FListenerEntry> Listeners;
+
+	/** Number of consumers interested in each HenetInterest bit. A bit is set in the reader's mask while its count is non-zero. */
+	int32 InterestCounts[32] = {};
+
+	struct FPendingEdgeWait
+	{
+		uint32 InterestBit = 0;
+		/** FPlatformTime::Seconds() after which the wait times out, or 0 for none. */
+		double Deadline = 0.0;
+		TPromise<EHenetWaitResult> Promise;
+	};
+
+	/** Fulfils the waits that match the given events, then times out the expired ones. */
+	void ResolveEdgeWaits(TConstArrayView<FHenetSwitchEvent> Events);
+
+	/** Fulfils every pending wait with the given result. */
+	void ResolveAllEdgeWaits(EHenetWaitResult Result);
+
+	/** Outstanding NextEdge waits, in the order they were started. */
+	TArray<FPendingEdgeWait> EdgeWaits;
+
+	/** Drops pre-roll events beyond the configured count and age. */
+	void TrimPreRoll();
+
+	/** Ends pre-roll and releases the interest it held on the reader. */
+	void StopPreRoll();
+
+	/** True while events are kept for the first listener (see EnablePreRoll). */
+	bool bPreRollActive = false;
+	int32 PreRollMaxEvents = 0;
+	double PreRollMaxAgeSeconds = 0.0;
+
+	/** Events kept for the first listener, oldest first. */
+	TArray<FHenetSwitchEvent> PreRollEvents;
+
+	/** Reused every frame so draining the queue does not allocate once it has grown. */
+	TArray<FHenetSwitchEvent> PendingEvents;
+
+	/** True while DispatchPendingEvents is calling listeners. */
+	bool bDispatching = false;
+
+	/** Trace index up to which LogTrace has already printed. */
+	uint64 TraceReadIndex = 0;
+
+	/** Reused by LogTrace. */
+	TArray<FHenetTraceRecord> TraceRecords;
+
+	/** Formats a non-empty run of trace records to the log. Safe on any thread. */
+	static void LogTraceRecords(const FString& Port, TConstArrayView<FHenetTraceRecord> Records);
 };
\ No newline at end of file
@@ -7,6 +7,40 @@
 #include "HAL/Runnable.h"
 #include "Templates/Atomic.h"
 #include "Containers/Queue.h"
+#include "HenetAnalogChannel.h"
+#include "HenetWorkerCallbackList.h"
+#include "HenetSharedStateExport.h"
+#include "HenetTraceRing.h"
+#include "HenetCaptureFile.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/PlatformTime.h"
+#include <atomic>
+
+/**
+ * Interest bits, used to drop events nobody is listening to right after they are parsed.
+ * Connection status events are always delivered and have no bit.
+ */
+namespace HenetInterest
+{
+    constexpr uint32 None = 0;
+    constexpr uint32 Heartbeat = 1u << 0;
+    constexpr uint32 All = 0xFFFFFFFFu;
+
+    /** Highest switch number with interest bits. A device has 4; aggregate connections map several into one space. */
+    constexpr int32 MaxSwitchNumber = 15;
+
+    /** Bit for one switch edge: pressed edges use bits 1-15, released edges bits 16-30. */
+    constexpr uint32 SwitchEdge(int32 SwitchNumber, bool bPressed)
+    {
+        return 1u << (SwitchNumber + (bPressed ? 0 : MaxSwitchNumber));
+    }
+
+    /** Both edges of one switch. */
+    constexpr uint32 Switch(int32 SwitchNumber)
+    {
+        return SwitchEdge(SwitchNumber, true) | SwitchEdge(SwitchNumber, false);
+    }
+}
 
 // Define a struct to pass event data from the worker thread to the game thread
 struct FHenetSwitchEvent
@@ -14,9 +48,16 @@ struct FHenetSwitchEvent
     bool bIsHeartbeat = false;
     bool bIsConnectionStatus = false; // <-- NEW
     bool bIsConnected = false;        // <-- NEW (Payload for connection status)
-    int32 SwitchNumber = 0; // 1-4
+    int32 SwitchNumber = 0; // 1-4 (up to HenetInterest::MaxSwitchNumber on an aggregate connection)
     bool bIsPressed = false;
 
+    /**
+     * FPlatformTime::Cycles64() at which the last byte of the frame arrived: the read completion time,
+     * moved back by one byte time for every byte that followed it in the same read.
+     * Convert with FPlatformTime::ToSeconds64, or see UHenetSwitchControlLibrary::ConvertHenetTimestampToGameTime.
+     */
+    uint64 TimestampCycles = 0;
+
     FHenetSwitchEvent() {}
 
     FHenetSwitchEvent(bool bHeartbeat)
@@ -31,19 +72,79 @@ struct FHenetSwitchEvent
         FHenetSwitchEvent Event;
         Event.bIsConnectionStatus = true;
         Event.bIsConnected = bConnected;
+        Event.TimestampCycles = FPlatformTime::Cycles64();
         return Event;
     }
     // <-- End of new code -->
+
+    /** TimestampCycles on the FPlatformTime::Seconds() clock (the clock FApp::GetCurrentTime uses). */
+    double GetTimestampSeconds() const
+    {
+        return FPlatformTime::Seconds() - FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - TimestampCycles);
+    }
+
+    /** The interest bit this event matches, or HenetInterest::None if it is always delivered. */
+    uint32 GetInterestBit() const
+    {
+        if (bIsConnectionStatus) return HenetInterest::None;
+        if (bIsHeartbeat) return HenetInterest::Heartbeat;
+        if (SwitchNumber < 1 || SwitchNumber > HenetInterest::MaxSwitchNumber) return HenetInterest::None;
+        return HenetInterest::SwitchEdge(SwitchNumber, bIsPressed);
+    }
+
+    /** True if a listener with the given interest mask wants this event. */
+    bool MatchesInterest(uint32 InterestMask) const
+    {
+        const uint32 Bit = GetInterestBit();
+        return Bit == HenetInterest::None || (InterestMask & Bit) != 0;
+    }
+};
+
+/** Snapshot of the reader's link-quality counters (all values are totals since the port was opened). */
+struct FHenetLinkCounters
+{
+    /** Frames that passed framing (and, for v2 frames, the checksum). */
+    int32 FramesReceived = 0;
+
+    /** v2 frames whose checksum did not match. */
+    int32 FramesCorrupt = 0;
+
+    /** v2 frames inferred missing from gaps in the sequence numbers, minus those recovered. */
+    int32 FramesLost = 0;
+
+    /** Missing v2 frames that arrived later through a retransmission request. */
+    int32 FramesRecovered = 0;
+
+    /** Bytes that broke the framing (unexpected DLE/STX/ETX, invalid fields). */
+    int32 ParseErrors = 0;
+
+    /** True once the device has sent at least one valid v2 frame. */
+    bool bProtocolV2 = false;
 };
 
 /**
  * FRunnable class to handle serial port communication on a separate thread.
+ *
+ * Two frame formats are accepted on the same link, and can be mixed:
+ *   v1: ENQ DLE STX <body> DLE ETX
+ *   v2: ENQ DLE STX 'V' <seq> <body> <crc> DLE ETX
+ * where <seq> and <crc> are two ASCII hex digits each, and <crc> is a CRC-8 (poly 0x07)
+ * over every byte from 'V' to the end of <body>. A device is switched to v2 automatically
+ * the first time a valid v2 frame is seen; gaps in <seq> are counted as lost frames and,
+ * if henet.RequestRetransmit is set, requested again with ENQ DLE STX 'N' <seq> DLE ETX.
  */
 class HENETSWITCHCONTROL_API FHenetSerialPortReader : public FRunnable
 {
 public:
-    // Constructor
-    FHenetSerialPortReader(const FString& InPortName, TQueue<FHenetSwitchEvent, EQueueMode::Mpsc>& InEventQueue);
+    /**
+     * Spawns the reader thread.
+     * @param InReplayOptions If set, the capture file is streamed through the parser instead of opening
+     *                        InPortName; the port name is then only used for logging.
+     * @param InPrevious A stopped reader this one replaces. Its analog channel configuration and worker
+     *                   callbacks (with their handles) are taken over before the thread starts.
+     */
+    FHenetSerialPortReader(const FString& InPortName, TQueue<FHenetSwitchEvent, EQueueMode::Mpsc>& InEventQueue,
+        const FHenetReplayOptions* InReplayOptions = nullptr, const FHenetSerialPortReader* InPrevious = nullptr);
     
     // Destructor
     virtual ~FHenetSerialPortReader();
@@ -57,6 +158,57 @@ public:
     /** Signals to the thread to stop */
     void EnsureCompletion();
 
+    /** True once the thread has stopped, or was never able to start (e.g. the port failed to open). */
+    bool HasStopped() const { return StopTaskCounter.Load() != 0; }
+
+    /** True while the port is open and being read. Safe to call from any thread. */
+    bool IsConnected() const { return bConnected.load(std::memory_order_relaxed); }
+
+    /** Number of analog sample channels the protocol can address ('1'-'8'). */
+    static constexpr int32 NumAnalogChannels = 8;
+
+    /**
+     * Returns the worker-side ring for an analog channel, or nullptr if the index is out of range.
+     * @param Channel 1-based channel number, as sent by the device.
+     */
+    FHenetAnalogChannel* GetAnalogChannel(int32 Channel);
+
+    /**
+     * Sets which events the parser should queue; everything else is dropped straight after parsing.
+     * Safe to call from any thread. See HenetInterest for the bit layout.
+     */
+    void SetInterestMask(uint32 InMask) { InterestMask.Store(InMask, EMemoryOrder::Relaxed); }
+
+    /** Native callbacks run on this thread for every parsed event. Add/Remove are safe from any thread. */
+    FHenetWorkerCallbackList& GetWorkerCallbacks() { return WorkerCallbacks; }
+
+    /** Binary trace of raw bytes, parser transitions and errors. Readable from any thread. */
+    const FHenetTraceRing& GetTrace() const { return Trace; }
+
+    /** Turns a trace record into a log line. Times are printed relative to BaseCycles. */
+    static FString FormatTraceRecord(const FHenetTraceRecord& Record, uint64 BaseCycles);
+
+    /** Returns the current link-quality counters. Safe to call from any thread. */
+    FHenetLinkCounters GetLinkCounters() const;
+
+    /**
+     * Starts recording every byte read to a capture file (see FHenetCaptureFileHeader), replacing
+     * any capture in progress. Only the path is handed over: the reader thread creates the file at its
+     * next read, so this never touches the disk. A file that cannot be created is logged there.
+     * @param FilePath Full path of the file to create.
+     * @return False if the reader has stopped.
+     */
+    bool StartCapture(const FString& FilePath);
+
+    /** Stops the capture in progress, if any. The file is closed by the reader thread shortly after. */
+    void StopCapture();
+
+    /** True if this reader replays a capture file rather than reading a serial port. */
+    bool IsReplay() const { return bIsReplay; }
+
+    /** Line speed the port is configured with. */
+    static constexpr uint32 BaudRate = 9600;
+
 private:
     /**
      * Parses the incoming byte stream according to the Henet protocol.
@@ -64,6 +216,53 @@ private:
      */
     void ParseByte(uint8 Byte);
 
+    /**
+     * Hands a parsed event to the worker-thread callbacks, then queues it for the game thread
+     * unless no game-thread consumer has registered interest in it.
+     */
+    void DeliverEvent(const FHenetSwitchEvent& Event);
+
+    /** Flags the stop and releases the callback list when Init() fails, since Run() and Exit() will not follow. */
+    void MarkThreadFinished();
+
+    /** Counts a framing error and records it, with the current state and byte, in the trace. */
+    void NoteParseError(uint8 Byte);
+
+    /** Clears all per-frame parser data. Called on ENQ and after every complete or broken frame. */
+    void ResetFrame();
+
+    /**
+     * Checks the sequence number of a v2 frame whose checksum matched, updates the loss
+     * accounting and requests retransmission of any frames skipped over.
+     * @return False if the frame is a duplicate and must not be delivered again.
+     */
+    bool AcceptSequence(uint8 Sequence);
+
+    /**
+     * Starts sequence tracking over from Sequence: the first v2 frame on the link, or a device that
+     * restarted its numbering while the port stayed open. Forgets missing frames and edge order.
+     */
+    void ResyncSequence(uint8 Sequence);
+
+    /**
+     * Decides whether a switch edge of the current frame is delivered. A recovered edge that is older
+     * than one already delivered for the same switch is stale: delivering it would undo the newer
+     * edge (a lost press whose release came first would leave the switch stuck pressed).
+     */
+    bool AcceptEdge(int32 SwitchNumber);
+
+    /** Traces, captures and parses one chunk of bytes as returned by a single read. */
+    void ProcessRead(const uint8* Bytes, int32 Count);
+
+    /** Replaces the active capture with the one handed over by StartCapture/StopCapture, if any. */
+    void ApplyPendingCaptureCommand();
+
+    /** Run() for replay readers: streams the capture file through the parser at the requested pace. */
+    void RunReplay();
+
+    /** (Windows) Writes a framed message (ENQ DLE STX <Body> DLE ETX) to the device. */
+    bool WriteFrame(const uint8* Body, int32 BodyLength);
+
     /** Thread handle */
     FRunnableThread* Thread;
 
@@ -76,9 +275,53 @@ private:
     /** Atomic an_d volatile boolean to stop the thread */
     TAtomic<int32> StopTaskCounter;
 
+    /** FPlatformTime::Cycles64() taken when the current read completed; stamps trace records. */
+    uint64 CurrentReadCycles;
+
+    /** Estimated arrival time of the byte being parsed; stamps events. */
+    uint64 CurrentByteCycles;
+
+    /** Time one byte takes on the wire (start + 8 data + stop bits at BaudRate), in cycles. */
+    uint64 ByteDurationCycles;
+
+    /** Binary trace, written by this thread only. */
+    FHenetTraceRing Trace;
+
+    /** Combined interest of every consumer of this reader (HenetInterest bits). */
+    TAtomic<uint32> InterestMask;
+
+    /** Mirrors the last connection status event, for listeners that attach after it was sent. */
+    std::atomic<bool> bConnected;
+
     /** Handle to the serial port (Windows-specific) */
     void* hSerial; // Using void* to avoid including Windows.h in header
 
+    /** Callbacks invoked on this thread, see GetWorkerCallbacks. */
+    FHenetWorkerCallbackList WorkerCallbacks;
+
+    /** Live state published to shared memory for external processes (henet.SharedStateExport). Reader thread only. */
+    FHenetSharedStateExport SharedState;
+
+    /** Analog sample channels. Filled by the parser, drained by the game thread. */
+    FHenetAnalogChannel AnalogChannels[NumAnalogChannels];
+
+    /** True if this reader replays ReplayOptions.CapturePath instead of opening a port. */
+    bool bIsReplay;
+    FHenetReplayOptions ReplayOptions;
+
+    /** The capture being replayed. Reader thread only. */
+    TUniquePtr<FHenetCaptureReader> Replay;
+
+    /** The capture being written. Reader thread only. */
+    TUniquePtr<FHenetCaptureWriter> ActiveCapture;
+
+    /** Handoff from StartCapture/StopCapture to the reader thread, guarded by CaptureLock. Empty means "stop". */
+    FString PendingCapturePath;
+
+    /** Set when PendingCapturePath holds a command, so the reader only takes the lock when there is one. */
+    std::atomic<bool> bCaptureCommandPending;
+    FCriticalSection CaptureLock;
+
     // Protocol Constants
     enum EProtocolChars : uint8
     {
@@ -89,7 +332,10 @@ private:
         Proto_S = 0x53,
         Proto_H = 0x48,
         Proto_P = 0x50,
-        Proto_R = 0x52
+        Proto_R = 0x52,
+        Proto_A = 0x41,
+        Proto_V = 0x56, // v2 frame prefix
+        Proto_N = 0x4E  // Retransmission request (host to device)
     };
 
     // Parser state machine
@@ -99,13 +345,52 @@ private:
         Find_DLE1,
         Find_STX,
         Find_Type,
+        Find_Sequence,
         Find_SwitchNum,
         Find_EventType,
+        Find_AnalogChannel,
+        Find_AnalogValue,
+        Find_Checksum,
         Find_DLE2,
         Find_ETX
     };
 
+    /** State that follows the last byte of a message body: the checksum for v2 frames, otherwise DLE. */
+    EParserState StateAfterBody() const { return bTempIsV2Frame ? EParserState::Find_Checksum : EParserState::Find_DLE2; }
+
     EParserState ParserState;
+    uint8 TempMessageType;
     uint8 TempSwitchNum;
     uint8 TempEventType;
+    uint8 TempAnalogChannel;
+    uint16 TempAnalogValue;
+    int32 TempAnalogDigits;
+
+    // v2 framing, per frame
+    bool bTempIsV2Frame;
+    /** Set by AcceptSequence when the frame is a retransmission of one that was given up on. */
+    bool bTempIsRecovered;
+    uint8 TempSequence;
+    uint8 TempChecksum;
+    int32 TempHexDigits;
+    uint8 RunningCrc;
+
+    // v2 sequencing, per link (worker thread only)
+    bool bHaveSequence;
+    uint8 ExpectedSequence;
+    /** One bit per sequence number that was skipped and has not been recovered yet. */
+    uint32 MissingSequences[8];
+    /** Consecutive frames treated as behind, each following the previous one, and the sequence the run expects next. */
+    int32 BehindRunLength;
+    uint8 BehindRunNext;
+    /** Sequence number of the last v2 edge delivered for each switch (1-4), or -1 if none yet. */
+    int32 LastEdgeSequence[4];
+
+    // Link-quality counters, written by the worker and read from any thread
+    TAtomic<int32> FramesReceived;
+    TAtomic<int32> FramesCorrupt;
+    TAtomic<int32> FramesLost;
+    TAtomic<int32> FramesRecovered;
+    TAtomic<int32> ParseErrors;
+    std::atomic<bool> bLinkIsV2;
 };
\ No newline at end of file
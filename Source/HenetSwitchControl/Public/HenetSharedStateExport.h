@@ -0,0 +1,106 @@
+// Copyright Henet LLC 2025
+// Publishes live switch state into named shared memory for external processes.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformMemory.h"
+#include <atomic>
+
+struct FHenetSwitchEvent;
+
+/**
+ * Switch state as seen by external readers. Plain data, fixed layout (LayoutVersion 1).
+ * Times are FPlatformTime::Cycles64() values, i.e. QueryPerformanceCounter ticks on Windows;
+ * multiply a difference by SecondsPerCycle to get seconds.
+ */
+struct FHenetSharedSwitchData
+{
+	/** Bit (N-1) is set while switch N is held down. */
+	uint32 PressedMask;
+
+	/** 1 while the serial port is open and being read, otherwise 0. */
+	uint32 bConnected;
+
+	/** Seconds per tick of the timestamps below. */
+	double SecondsPerCycle;
+
+	uint64 PressCount[4];
+	uint64 ReleaseCount[4];
+
+	/** Timestamp of the last press or release of each switch, 0 if none yet. */
+	uint64 LastEdgeCycles[4];
+
+	uint64 HeartbeatCount;
+
+	/** Timestamp of the last heartbeat, 0 if none yet. Heartbeat age = now - this. */
+	uint64 LastHeartbeatCycles;
+
+	/** Timestamp of the last change to anything in this block. */
+	uint64 LastUpdateCycles;
+};
+
+/**
+ * The shared-memory segment: a header followed by the data, guarded by a seqlock.
+ *
+ * Readers (any process, any number, wait-free for the writer):
+ *   1. read Sequence; if odd, a write is in progress: retry
+ *   2. copy Data
+ *   3. read Sequence again; if it changed, retry
+ * FHenetSharedStateExport::TryRead implements exactly this.
+ */
+struct FHenetSharedSwitchBlock
+{
+	static constexpr uint32 ExpectedMagic = 0x53574548; // "HEWS" in memory order: 'H','E','W','S'
+	static constexpr uint32 ExpectedLayoutVersion = 1;
+
+	uint32 Magic;
+	uint32 LayoutVersion;
+	std::atomic<uint32> Sequence;
+	uint32 Padding;
+	FHenetSharedSwitchData Data;
+};
+
+static_assert(std::atomic<uint32>::is_always_lock_free, "The seqlock counter must be lock-free to be shared across processes");
+
+/**
+ * Writer side of the shared-memory export, owned by one serial reader.
+ * The segment is named "HenetSwitchControl_<Port>" (e.g. HenetSwitchControl_COM3). On Windows it
+ * lives in the session namespace, so external readers open "Local\HenetSwitchControl_COM3".
+ * All methods except Open/Close are called on the reader thread only.
+ */
+class HENETSWITCHCONTROL_API FHenetSharedStateExport
+{
+public:
+	~FHenetSharedStateExport();
+
+	/** Creates (or attaches to) the named segment for a port. Returns false if shared memory is unavailable. */
+	bool Open(const FString& PortName);
+
+	/** Unmaps the segment. */
+	void Close();
+
+	/** True if the segment is mapped. */
+	bool IsOpen() const { return Block != nullptr; }
+
+	/** Folds one event into the published state, stamped with the event's own timestamp. */
+	void PublishEvent(const FHenetSwitchEvent& Event);
+
+	/** Returns the segment name used for a port, for documentation and external tools. */
+	static FString MakeSegmentName(const FString& PortName);
+
+	/**
+	 * Seqlock read of a mapped block. Returns false if the block is not a valid Henet export, or if
+	 * no consistent copy could be taken after a bounded number of attempts (writer died mid-update).
+	 */
+	static bool TryRead(const FHenetSharedSwitchBlock& Block, FHenetSharedSwitchData& OutData);
+
+private:
+#if PLATFORM_WINDOWS
+	/** File mapping handle backing Block (a HANDLE; void* keeps Windows.h out of this header). */
+	void* MappingHandle = nullptr;
+#else
+	FPlatformMemory::FSharedMemoryRegion* Region = nullptr;
+#endif
+	FHenetSharedSwitchBlock* Block = nullptr;
+};
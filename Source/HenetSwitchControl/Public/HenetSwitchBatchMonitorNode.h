@@ -0,0 +1,48 @@
+// Copyright Henet LLC 2025
+// Blueprint node that delivers a connection's events as one array per frame.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HenetSwitchListenerNodeBase.h"
+#include "HenetSwitchBatchMonitorNode.generated.h"
+
+// Delivers every event of a frame in one call.
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FHenetMonitorEventBatch, const TArray<FHenetSwitchEventData>&, Events);
+
+/**
+ * Blueprint node that hands over every event of a frame in a single call, instead of one or two
+ * pin executions per event as ListenForHenetSwitchEvents does. A burst of events costs one
+ * Blueprint call, and the array is reused from frame to frame.
+ */
+UCLASS()
+class HENETSWITCHCONTROL_API UHenetSwitchBatchMonitorNode : public UHenetSwitchListenerNodeBase
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Starts delivering the events of the specified serial connection, one batch per frame.
+	 * Connection changes are part of the batch (Connected / Disconnected events); if the connection
+	 * is already up, the first batch is a single Connected event.
+	 * @param Connection The connection object from "OpenHenetSerialConnection".
+	 * @param Switches The switches whose press and release events this node needs. Leave empty for all of them.
+	 * @param bHeartbeat Whether this node needs heartbeat events.
+	 */
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", ExposedAsyncProxy = "AsyncAction", AutoCreateRefTerm = "Switches"), Category = "Henet Switch Control")
+	static UHenetSwitchBatchMonitorNode* ListenForHenetSwitchEventBatches(UObject* WorldContextObject, UHenetSerialConnection* Connection, const TArray<int32>& Switches, bool bHeartbeat = true);
+
+	/** Fired at most once per frame with all of that frame's events, oldest first. */
+	UPROPERTY(BlueprintAssignable)
+	FHenetMonitorEventBatch OnEventBatch;
+
+protected:
+	// UHenetSwitchListenerNodeBase interface
+	virtual void OnStartedListening(bool bAlreadyConnected) override;
+	virtual void DispatchEvents(TConstArrayView<FHenetSwitchEvent> Events) override;
+	// ~UHenetSwitchListenerNodeBase interface
+
+private:
+	/** This frame's events. Reset, not freed, between frames. */
+	TArray<FHenetSwitchEventData> BatchBuffer;
+};
@@ -9,6 +9,18 @@
 #include "HenetSerialConnection.h" // For UHenetSerialConnection
 #include "HenetSwitchControlLibrary.generated.h"
 
+/** How fast OpenHenetReplayConnection plays a capture back. */
+UENUM(BlueprintType)
+enum class EHenetReplaySpeed : uint8
+{
+    /** At the pace it was recorded. */
+    Original,
+    /** AccelerationFactor times faster than recorded. */
+    Accelerated,
+    /** As fast as the parser can consume it, e.g. for benchmarks and regression runs. */
+    Max
+};
+
 /**
  * Provides nodes to open and close a Henet Serial Connection.
  */
@@ -21,7 +33,9 @@ public:
 
     /**
      * (NODE 1)
-     * Opens a new serial port connection and returns a reference to it.
+     * Opens a serial port connection and returns a reference to it.
+     * If the port is already open (elsewhere, or still warm from a previous level) the existing
+     * connection is shared rather than reopened. Each call must be paired with a Close.
      * You must listen for the "OnConnected" event (from Node 2) to know if it succeeded.
      * @param PortName The name of the serial port (e.g., "COM3").
      * @return A new UHenetSerialConnection object.
@@ -31,9 +45,42 @@ public:
 
     /**
      * (NODE 3)
-     * Closes a serial port connection.
+     * Releases a serial port connection. The port itself is closed once every Open has been
+     * matched by a Close and the linger period (henet.ConnectionLingerSeconds) has passed.
      * @param Connection The connection object returned from "OpenHenetSerialConnection".
      */
     UFUNCTION(BlueprintCallable, Category = "Henet Switch Control", meta = (Keywords = "close serial com port henet"))
     static void CloseHenetSerialConnection(UHenetSerialConnection* Connection);
+
+    /**
+     * Opens a connection that replays a capture file (recorded with StartCapture) through the
+     * normal parser, in place of a device. Use it with the monitor node exactly like a serial
+     * connection, and close it with CloseHenetSerialConnection.
+     * @param CapturePath The .hcap file. Relative paths are looked up under Saved/HenetCaptures.
+     * @param Speed Original pace, accelerated, or as fast as possible.
+     * @param AccelerationFactor Speed-up used when Speed is Accelerated.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Henet Switch Control|Capture", meta = (Keywords = "replay capture henet"))
+    static UHenetSerialConnection* OpenHenetReplayConnection(const FString& CapturePath, EHenetReplaySpeed Speed = EHenetReplaySpeed::Original, float AccelerationFactor = 10.0f);
+
+    /**
+     * Opens one connection that merges several devices into a single stream, ordered by event
+     * timestamp rather than by which port happened to be read first. Give each device a switch
+     * offset so their switches do not collide (switch numbers up to 15 can be filtered on).
+     * Close it with Close Henet Serial Connection; the devices stay usable on their own.
+     * Not supported with cluster sync: with a cluster role set, the returned connection stays closed.
+     * @param ReorderWindowMs Longest an event is held back waiting for an earlier one from another device.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Henet Switch Control", meta = (Keywords = "aggregate merge multiple henet"))
+    static UHenetSerialConnection* OpenHenetAggregateConnection(const TArray<FHenetAggregateDevice>& Devices, float ReorderWindowMs = 20.0f);
+
+    /**
+     * Places an event timestamp on the world's timeline (the same clock as Get Game Time In Seconds),
+     * with sub-frame precision. Compare the result with the time a note or cue was due to get the
+     * player's true timing error, independent of frame rate and of when the event was dispatched.
+     * Time dilation is taken into account; time spent paused is not.
+     * @param TimestampSeconds An event timestamp (FHenetSwitchEventData::TimestampSeconds or the monitor node's GetEventTimestamp).
+     */
+    UFUNCTION(BlueprintPure, Category = "Henet Switch Control", meta = (WorldContext = "WorldContextObject", Keywords = "timestamp time game henet"))
+    static double ConvertHenetTimestampToGameTime(const UObject* WorldContextObject, double TimestampSeconds);
 };
\ No newline at end of file
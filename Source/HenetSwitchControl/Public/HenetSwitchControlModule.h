@@ -5,14 +5,49 @@
 
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
+#include "Templates/UniquePtr.h"
+#include "Containers/Ticker.h"
+#include "UObject/WeakObjectPtr.h"
+
+class FHenetConnectionRegistry;
+class UHenetSerialConnection;
 
 // Declare the module's log category
 DECLARE_LOG_CATEGORY_EXTERN(LogHenetSwitchControl, Log, All);
 
-class FHenetSwitchControlModule : public IModuleInterface
+class HENETSWITCHCONTROL_API FHenetSwitchControlModule : public IModuleInterface
 {
 public:
     /** IModuleInterface implementation */
     virtual void StartupModule() override;
     virtual void ShutdownModule() override;
-};
\ No newline at end of file
+
+    /** Returns the loaded module instance. */
+    static FHenetSwitchControlModule& Get()
+    {
+        return FModuleManager::LoadModuleChecked<FHenetSwitchControlModule>("HenetSwitchControl");
+    }
+
+    /** Returns the registry that shares one connection per serial port. */
+    FHenetConnectionRegistry& GetConnectionRegistry() const { return *ConnectionRegistry; }
+
+    /** False before startup and after shutdown of the module. */
+    bool HasConnectionRegistry() const { return ConnectionRegistry.IsValid(); }
+
+private:
+    /** Opens the ports listed in UHenetSwitchControlSettings::WarmPorts and holds a reference to each. */
+    void OpenWarmConnections();
+
+    /** Logs new trace records periodically while henet.TraceFlushInterval is set. */
+    bool TickTraceFlush(float DeltaTime);
+
+    TUniquePtr<FHenetConnectionRegistry> ConnectionRegistry;
+
+    FTSTicker::FDelegateHandle TraceFlushTickerHandle;
+
+    /** Registry references held for the whole session on behalf of the warm ports. */
+    TArray<TWeakObjectPtr<UHenetSerialConnection>> WarmConnections;
+
+    FDelegateHandle PostEngineInitHandle;
+    double NextTraceFlushTime = 0.0;
+};
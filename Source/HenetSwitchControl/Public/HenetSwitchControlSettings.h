@@ -0,0 +1,45 @@
+// Copyright Henet LLC 2025
+// Project settings for the Henet Switch Control plugin.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "HenetSwitchControlSettings.generated.h"
+
+/**
+ * Project Settings > Plugins > Henet Switch Control.
+ * Stored in DefaultGame.ini under [/Script/HenetSwitchControl.HenetSwitchControlSettings].
+ */
+UCLASS(Config = Game, DefaultConfig, meta = (DisplayName = "Henet Switch Control"))
+class HENETSWITCHCONTROL_API UHenetSwitchControlSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UHenetSwitchControlSettings();
+
+	/**
+	 * Serial ports (e.g. "COM3") opened as soon as the engine has started and kept open for the
+	 * whole session. OpenHenetSerialConnection then attaches to the running reader instead of
+	 * opening the device, so no input is lost and the first press carries no startup latency.
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = "Warm Connections")
+	TArray<FString> WarmPorts;
+
+	/** Also open the warm ports in the editor. Off by default so the editor does not hold ports that a standalone game needs. */
+	UPROPERTY(Config, EditAnywhere, Category = "Warm Connections")
+	bool bWarmPortsInEditor = false;
+
+	/** Keep the events a warm port receives before anything listens, and deliver them to the first listener. */
+	UPROPERTY(Config, EditAnywhere, Category = "Warm Connections")
+	bool bPreRoll = false;
+
+	/** Most recent events kept for the first listener. */
+	UPROPERTY(Config, EditAnywhere, Category = "Warm Connections", meta = (EditCondition = "bPreRoll", ClampMin = "1"))
+	int32 PreRollMaxEvents = 64;
+
+	/** Pre-roll events older than this when the first listener attaches are dropped. */
+	UPROPERTY(Config, EditAnywhere, Category = "Warm Connections", meta = (EditCondition = "bPreRoll", ClampMin = "0", Units = "s"))
+	float PreRollMaxAgeSeconds = 5.0f;
+};
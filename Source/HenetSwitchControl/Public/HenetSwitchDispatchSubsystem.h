@@ -0,0 +1,55 @@
+// Copyright Henet LLC 2025
+// Engine subsystem that drains every open connection once per frame.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "UObject/WeakObjectPtr.h"
+#include "HenetSwitchDispatchSubsystem.generated.h"
+
+class UHenetSerialConnection;
+
+/**
+ * Pumps all open Henet connections exactly once per engine frame.
+ *
+ * Dispatch happens on FCoreDelegates::OnBeginFrame, before any world starts ticking
+ * (i.e. ahead of TG_PrePhysics). Every listener therefore sees a given event in the same
+ * frame, and gameplay that ticks later in the frame always observes the input already applied.
+ * This replaces the per-listener 10 ms timers, whose firing was unrelated to frame boundaries.
+ */
+UCLASS()
+class HENETSWITCHCONTROL_API UHenetSwitchDispatchSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the subsystem, or nullptr if the engine is not up yet (or is shutting down). */
+	static UHenetSwitchDispatchSubsystem* Get();
+
+	// USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// ~USubsystem interface
+
+	/** Adds a connection to the per-frame pump. Called by UHenetSerialConnection::Open. */
+	void AddConnection(UHenetSerialConnection* Connection);
+
+	/** Removes a connection from the per-frame pump. Called by UHenetSerialConnection::Close. */
+	void RemoveConnection(UHenetSerialConnection* Connection);
+
+	/**
+	 * Calls Visitor for every open connection, including replay and aggregate connections that the
+	 * connection registry does not know about. The visitor must not open or close connections.
+	 */
+	void ForEachConnection(TFunctionRef<void(UHenetSerialConnection&)> Visitor) const;
+
+private:
+	/** Drains and dispatches every registered connection. */
+	void OnBeginFrame();
+
+	/** Connections to pump. Weak so that a destroyed connection simply drops out. */
+	TArray<TWeakObjectPtr<UHenetSerialConnection>> Connections;
+
+	FDelegateHandle BeginFrameHandle;
+};
@@ -0,0 +1,88 @@
+// Copyright Henet LLC 2025
+// Shared listener lifecycle and interest handling of the Blueprint monitor nodes.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "HenetSerialConnection.h"
+#include "HenetSwitchListenerNodeBase.generated.h"
+
+/**
+ * Base of the Blueprint nodes that listen to a Henet connection. It owns registration with the
+ * connection, the world-context check, teardown and the interest mask; subclasses only turn the
+ * events they receive into pin executions.
+ */
+UCLASS(Abstract)
+class HENETSWITCHCONTROL_API UHenetSwitchListenerNodeBase : public UBlueprintAsyncActionBase, public IHenetSwitchEventListener
+{
+	GENERATED_BODY()
+
+public:
+	// UBlueprintAsyncActionBase interface
+	virtual void Activate() override;
+	virtual void SetReadyToDestroy() override;
+	// ~UBlueprintAsyncActionBase interface
+
+	// IHenetSwitchEventListener interface
+	virtual void HandleHenetEvents(UHenetSerialConnection* Connection, TConstArrayView<FHenetSwitchEvent> Events) override;
+	// ~IHenetSwitchEventListener interface
+
+	// UObject interface
+	virtual void BeginDestroy() override;
+	// ~UObject interface
+
+	/**
+	 * Stops listening for events *on this node*.
+	 * This does NOT close the serial port. Use "CloseHenetSerialConnection" for that.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Henet Switch Control")
+	void StopListening();
+
+	/**
+	 * Changes the events this node receives, replacing the Switches and Heartbeat inputs of the node.
+	 * Events that no listener on the connection wants are dropped on the reader thread, so idle
+	 * switches and heartbeats cost nothing. The node cannot tell which of its pins are wired, so
+	 * filtering only happens when it is asked for here or on the node's inputs.
+	 * Connection status events are always delivered.
+	 * @param bHeartbeat Receive heartbeat events.
+	 * @param Switches The switch numbers (1-4, or the mapped numbers of an aggregate connection) whose press and release events to receive.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Henet Switch Control")
+	void SetEventInterest(bool bHeartbeat, const TArray<int32>& Switches);
+
+	/** Builds an interest mask from a list of switch numbers, skipping (and logging) invalid ones. */
+	static uint32 MakeSwitchInterest(const TArray<int32>& Switches);
+
+protected:
+	/**
+	 * Sets up a node created by a factory function from the node's inputs, and keeps it alive
+	 * through the game instance until SetReadyToDestroy.
+	 */
+	void InitListener(UObject* InWorldContextObject, UHenetSerialConnection* Connection, const TArray<int32>& Switches, bool bHeartbeat);
+
+	/**
+	 * Called at the end of a successful Activate, once the node is registered.
+	 * @param bAlreadyConnected True if the connection was up before this node started listening, in
+	 *        which case its status event was consumed long ago and the node has to report it itself.
+	 */
+	virtual void OnStartedListening(bool bAlreadyConnected) {}
+
+	/** Delivers one frame's events. Filtering against InterestMask is left to the subclass. */
+	virtual void DispatchEvents(TConstArrayView<FHenetSwitchEvent> Events) PURE_VIRTUAL(UHenetSwitchListenerNodeBase::DispatchEvents, );
+
+	/** The events this node wants (HenetInterest bits). */
+	uint32 InterestMask = HenetInterest::All;
+
+private:
+	/** The object whose world this listener belongs to. Listening stops once it is destroyed. */
+	UPROPERTY()
+	TObjectPtr<UObject> WorldContextObject;
+
+	/** The connection object we are listening to. */
+	UPROPERTY()
+	TObjectPtr<UHenetSerialConnection> TargetConnection;
+
+	/** True while registered as a listener on TargetConnection. */
+	bool bIsListening = false;
+};
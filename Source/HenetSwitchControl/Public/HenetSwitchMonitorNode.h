@@ -5,9 +5,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Kismet/BlueprintAsyncActionBase.h"
+#include "HenetSwitchListenerNodeBase.h"
 #include "Containers/Queue.h"
-#include "TimerManager.h"
 // #include "HenetSerialPortReader.h" // No longer need this, HenetSerialConnection.h includes it
 #include "HenetSerialConnection.h" // <-- NEW: Include the connection object
 #include "HenetSwitchMonitorNode.generated.h"
@@ -21,7 +20,7 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE(FHenetMonitorNoParams);
  * Blueprint node to monitor events from an *existing* Henet Serial Connection.
  */
 UCLASS()
-class HENETSWITCHCONTROL_API UHenetSwitchMonitorNode : public UBlueprintAsyncActionBase
+class HENETSWITCHCONTROL_API UHenetSwitchMonitorNode : public UHenetSwitchListenerNodeBase
 {
 	GENERATED_BODY()
 
@@ -29,22 +28,32 @@ public:
 	/**
 	 * Starts listening for switch and heartbeat events from the specified serial connection.
 	 * @param Connection The connection object from "OpenHenetSerialConnection".
+	 * @param Switches The switches whose press and release events this node needs. Leave empty for all of them.
+	 * @param bHeartbeat Whether this node needs heartbeat events.
 	 */
 	 // <-- MODIFIED: Function signature changed -->
-	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", ExposedAsyncProxy = "AsyncAction"), Category = "Henet Switch Control")
-	static UHenetSwitchMonitorNode* ListenForHenetSwitchEvents(UObject* WorldContextObject, UHenetSerialConnection* Connection);
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", ExposedAsyncProxy = "AsyncAction", AutoCreateRefTerm = "Switches"), Category = "Henet Switch Control")
+	static UHenetSwitchMonitorNode* ListenForHenetSwitchEvents(UObject* WorldContextObject, UHenetSerialConnection* Connection, const TArray<int32>& Switches, bool bHeartbeat = true);
 
-	// UBlueprintAsyncActionBase interface
-	virtual void Activate() override;
-	virtual void SetReadyToDestroy() override;
-	// ~UBlueprintAsyncActionBase interface
+	/**
+	 * Arrival time (platform clock) of the event whose pin is currently firing. Call it from the
+	 * AsyncAction pin inside an OnSwitchN/OnHeartbeat handler and pass the result to
+	 * ConvertHenetTimestampToGameTime for sub-frame accurate timing.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Henet Switch Control")
+	double GetEventTimestamp() const { return CurrentEventTimestamp; }
 
 	/**
-	 * Stops listening for events *on this node*.
-	 * This does NOT close the serial port. Use "CloseHenetSerialConnection" for that.
+	 * Switch number of the event whose pin is currently firing, or 0 for heartbeats and connection
+	 * changes. On an aggregate connection switches above 4 only fire OnUpdate; call this (and
+	 * IsEventPressed) from the AsyncAction pin inside the OnUpdate handler to tell them apart.
 	 */
-	UFUNCTION(BlueprintCallable, Category = "Henet Switch Control")
-	void StopListening();
+	UFUNCTION(BlueprintPure, Category = "Henet Switch Control")
+	int32 GetEventSwitchNumber() const { return CurrentEventSwitchNumber; }
+
+	/** True if the event whose pin is currently firing is a switch press, false for a release or any other event. */
+	UFUNCTION(BlueprintPure, Category = "Henet Switch Control")
+	bool IsEventPressed() const { return bCurrentEventPressed; }
 
 	// --- OUTPUT EXECUTION PINS ---
 	// (These are all unchanged from before)
@@ -52,6 +61,7 @@ public:
 	/** (Catch-all) Fired for *every* event. */
 	UPROPERTY(BlueprintAssignable)
 	FHenetMonitorNoParams OnUpdate;
+
 // ... (rest of the delegates are identical) ...
 	/** Fired *only* when the serial port successfully connects. */
 	UPROPERTY(BlueprintAssignable)
@@ -98,27 +108,21 @@ public:
 	FHenetMonitorNoParams OnSwitch4Released;
 
 
-private:
-	/** Polls the event queue from the worker thread */
-	void CheckForUpdates();
-
-	/** Callback for the timer */
-	UFUNCTION()
-	void TimerCallback();
-	
-	/** Handle to the world's timer manager */
-	UPROPERTY()
-	TObjectPtr<UObject> WorldContextObject;
-
-	/** Timer handle for polling */
-	FTimerHandle TimerHandle;
-
-	// --- MODIFIED: Replaced Worker and EventQueue with the Connection object ---
-	
-	/** The connection object we are listening to. */
-	UPROPERTY()
-	TObjectPtr<UHenetSerialConnection> TargetConnection;
+protected:
+	// UHenetSwitchListenerNodeBase interface
+	virtual void OnStartedListening(bool bAlreadyConnected) override;
+	virtual void DispatchEvents(TConstArrayView<FHenetSwitchEvent> Events) override;
+	// ~UHenetSwitchListenerNodeBase interface
 
+private:
 	/** Tracks the last known connection state to fire OnConnected/OnDisconnected only when it changes. */
 	bool bIsConnected = false;
+
+	/** Timestamp of the event being broadcast, see GetEventTimestamp. */
+	double CurrentEventTimestamp = 0.0;
+
+	/** Switch and edge of the event being broadcast, see GetEventSwitchNumber and IsEventPressed. */
+	int32 CurrentEventSwitchNumber = 0;
+	bool bCurrentEventPressed = false;
+
 };
\ No newline at end of file
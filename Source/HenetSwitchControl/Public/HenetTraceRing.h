@@ -0,0 +1,85 @@
+// Copyright Henet LLC 2025
+// Fixed-size binary trace records written by the serial reader and formatted lazily.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/** What a trace record describes. */
+enum class EHenetTraceKind : uint8
+{
+	/** Raw bytes from one read. Data holds up to 11 bytes; longer reads span several records. */
+	Bytes,
+	/** Parser state change. Arg0 = old state, Arg1 = new state, Arg2 = byte that caused it. */
+	Transition,
+	/** Framing error. Arg0 = parser state, Arg2 = offending byte. */
+	ParseError,
+	/** v2 checksum mismatch. Arg0 = received, Arg1 = computed. */
+	ChecksumError,
+	/** v2 sequence gap. Arg0 = expected, Arg1 = received. */
+	SequenceGap,
+	/** Parsed event. Arg0 = switch number (0 for heartbeat), Arg1 = pressed. */
+	Event,
+	/** Connection status change. Arg0 = connected. */
+	Connection
+};
+
+/** One trace record. Fixed 24 bytes so the ring never allocates and writes are a couple of stores. */
+struct FHenetTraceRecord
+{
+	/** FPlatformTime::Cycles64() of the read that produced this record. */
+	uint64 Cycles;
+	EHenetTraceKind Kind;
+	uint8 Arg0;
+	uint8 Arg1;
+	uint8 Arg2;
+	uint8 Length;
+	uint8 Data[11];
+};
+
+static_assert(sizeof(FHenetTraceRecord) == 24, "Trace records are meant to stay small and fixed-size");
+
+/**
+ * Single-producer ring of trace records. The serial reader thread writes; any thread may read a
+ * copy of the recent history. Old records are overwritten, the writer never waits.
+ */
+class HENETSWITCHCONTROL_API FHenetTraceRing
+{
+public:
+	/** Number of records kept. Must be a power of two. */
+	static constexpr uint32 Capacity = 4096;
+
+	FHenetTraceRing();
+
+	/** (Writer thread) Appends one record. */
+	void Record(EHenetTraceKind Kind, uint64 Cycles, uint8 Arg0 = 0, uint8 Arg1 = 0, uint8 Arg2 = 0)
+	{
+		const uint64 Index = WriteIndex.load(std::memory_order_relaxed);
+		FHenetTraceRecord& Slot = Records[Index & (Capacity - 1)];
+		Slot.Cycles = Cycles;
+		Slot.Kind = Kind;
+		Slot.Arg0 = Arg0;
+		Slot.Arg1 = Arg1;
+		Slot.Arg2 = Arg2;
+		Slot.Length = 0;
+		WriteIndex.store(Index + 1, std::memory_order_release);
+	}
+
+	/** (Writer thread) Appends raw bytes, split over as many records as needed. */
+	void RecordBytes(const uint8* Bytes, int32 Count, uint64 Cycles);
+
+	/** Index the next record will be written at; also the total number of records ever written. */
+	uint64 GetWriteIndex() const { return WriteIndex.load(std::memory_order_acquire); }
+
+	/**
+	 * (Any thread) Copies the records from FromIndex up to the current write position into Out.
+	 * Records that were overwritten before (or while) they could be copied are skipped.
+	 * @return The index to continue from next time.
+	 */
+	uint64 Read(uint64 FromIndex, TArray<FHenetTraceRecord>& Out) const;
+
+private:
+	std::atomic<uint64> WriteIndex;
+	FHenetTraceRecord Records[Capacity];
+};
@@ -0,0 +1,89 @@
+// Copyright Henet LLC 2025
+// Lock-free (for the reader) list of native callbacks invoked on the serial reader thread.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/Function.h"
+#include "Templates/SharedPointer.h"
+#include "Delegates/IDelegateInstance.h"
+#include <atomic>
+
+struct FHenetSwitchEvent;
+
+/** A native callback run on the reader thread. Must be thread-safe and must not block. */
+using FHenetWorkerCallback = TFunction<void(const FHenetSwitchEvent&)>;
+
+/**
+ * Callback list read by the serial reader thread without ever taking a lock.
+ *
+ * The list is an immutable snapshot published through an atomic pointer (RCU style).
+ * Add/Remove build a new snapshot under a writer-only lock and swap it in; the old one is
+ * retired and freed once the reader has passed a quiescent point (Quiesce, called between
+ * reads), which guarantees it no longer holds a pointer into it.
+ */
+class HENETSWITCHCONTROL_API FHenetWorkerCallbackList
+{
+public:
+	FHenetWorkerCallbackList();
+	~FHenetWorkerCallbackList();
+
+	/** Registers a callback for the events in InterestMask (HenetInterest bits). Any thread. */
+	FDelegateHandle Add(FHenetWorkerCallback Callback, uint32 InterestMask);
+
+	/**
+	 * Unregisters a callback. It may still be running (or run once more) on the reader thread when
+	 * this returns. The list owns the callable and destroys it only once the reader can no longer
+	 * reach it, so state the callable owns (e.g. captured shared pointers) stays valid; state it
+	 * merely points at has no safe point to be freed. Any thread.
+	 */
+	bool Remove(FDelegateHandle Handle);
+
+	/**
+	 * Registers every callback of Other here too, under the same handles, so callers can keep
+	 * using the handles they were given when a reader is replaced. Any thread.
+	 */
+	void CopyFrom(const FHenetWorkerCallbackList& Other);
+
+	/** (Reader thread) Invokes every callback interested in the event. */
+	void Invoke(const FHenetSwitchEvent& Event) const;
+
+	/** (Reader thread) Marks a point where the reader holds no snapshot, so retired ones can be freed. */
+	void Quiesce() { QuiescentEpoch.fetch_add(1); }
+
+	/** (Reader thread) Called as the reader thread ends. From then on retired snapshots are freed right away. */
+	void ReaderFinished();
+
+private:
+	struct FEntry
+	{
+		FDelegateHandle Handle;
+		uint32 InterestMask = 0;
+		TSharedRef<const FHenetWorkerCallback, ESPMode::ThreadSafe> Callback;
+	};
+
+	/** Immutable once published. */
+	struct FSnapshot
+	{
+		TArray<FEntry> Entries;
+	};
+
+	/** Swaps in a new snapshot and retires the old one. WriterLock must be held. */
+	void Publish(const FSnapshot* NewSnapshot);
+
+	/** Frees retired snapshots the reader can no longer see. WriterLock must be held. */
+	void ReclaimRetired();
+
+	std::atomic<const FSnapshot*> Current;
+	std::atomic<uint64> QuiescentEpoch;
+
+	/** Set by ReaderFinished; nothing can be looking at a snapshot any more. */
+	std::atomic<bool> bReaderFinished;
+
+	/** Serializes writers. Never taken by the reader thread. */
+	mutable FCriticalSection WriterLock;
+
+	/** Snapshots swapped out, with the epoch that must be exceeded before they can be freed. */
+	TArray<TPair<uint64, const FSnapshot*>> Retired;
+};